@@ -0,0 +1,235 @@
+/*
+* ArtNetRx.cpp - Art-Net receiver for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "E131Rx.h"
+#include "ArtNetRx.h"
+
+static const uint8_t ARTNET_ID[8] = { 'A', 'r', 't', '-', 'N', 'e', 't', 0 };
+
+/* ArtPollReply, describes up to four ports sharing a Net and SubNet */
+typedef struct {
+    uint8_t  id[8];
+    uint16_t opcode;
+    uint8_t  ip[4];
+    uint16_t port;
+    uint16_t version;
+    uint8_t  net;
+    uint8_t  subnet;
+    uint16_t oem;
+    uint8_t  ubea;
+    uint8_t  status1;
+    uint16_t esta;
+    char     short_name[18];
+    char     long_name[64];
+    char     node_report[64];
+    uint16_t num_ports;
+    uint8_t  port_types[4];
+    uint8_t  good_input[4];
+    uint8_t  good_output[4];
+    uint8_t  sw_in[4];
+    uint8_t  sw_out[4];
+    uint8_t  sw_video;
+    uint8_t  sw_macro;
+    uint8_t  sw_remote;
+    uint8_t  spare[3];
+    uint8_t  style;
+    uint8_t  mac[6];
+    uint8_t  bind_ip[4];
+    uint8_t  bind_index;
+    uint8_t  status2;
+    uint8_t  filler[26];
+} __attribute__((packed)) artnet_pollreply_t;
+
+#define ARTNET_PORT_OUTPUT  0x80    /* Port type, can output from Art-Net */
+#define ARTNET_GOOD_OUTPUT  0x80    /* Output status, data being transmitted */
+#define ARTNET_STYLE_NODE   0x00    /* A DMX to / from Art-Net device */
+#define ARTNET_STATUS2_V3   0x08    /* Node supports 15 bit port-addresses */
+
+ArtNetRx::ArtNetRx(uint8_t slots) {
+    // One spare so a full ring can be told from an empty one, allocated in begin()
+    this->slots = slots + 1;
+    slot = nullptr;
+    head = 0;
+    tail = 0;
+    first = 0;
+    last = 0;
+    sequence = nullptr;
+}
+
+bool ArtNetRx::begin(String shortName, String longName) {
+    this->shortName = shortName;
+    this->longName = longName;
+
+    if (!slot) {
+        if (!(slot = static_cast<artnet_packet_t *>(malloc(slots * sizeof(artnet_packet_t)))))
+            return false;
+    }
+
+    if (!udp.listen(ARTNET_DEFAULT_PORT))
+        return false;
+
+    udp.onPacket(std::bind(&ArtNetRx::parsePacket, this, std::placeholders::_1));
+    return true;
+}
+
+void ArtNetRx::setUniverses(uint16_t first, uint16_t last) {
+    this->first = first;
+    this->last = last;
+
+    if (sequence) free(sequence);
+    sequence = static_cast<uint8_t *>(calloc(last - first + 1, 1));
+}
+
+bool ArtNetRx::accept(const artnet_packet_t *packet, int8_t &seqDiff) {
+    uint16_t port = packet->port_address & 0x7fff;
+    seqDiff = 0;
+    if (!packet->sequence || !sequence || port < first || port > last)
+        return true;
+
+    // Sequence runs 1-255, so differences are taken round 255
+    uint8_t &next = sequence[port - first];
+    if (next) {
+        int16_t diff = (packet->sequence + 255 - next) % 255;
+        seqDiff = diff > 127 ? diff - 255 : diff;
+    }
+    if (seqDiff < 0 && seqDiff >= -E131_SEQ_WINDOW) {
+        stats.late++;
+        return false;
+    }
+    if (seqDiff > 0)
+        stats.seq_errors++;
+    next = packet->sequence % 255 + 1;
+    return true;
+}
+
+artnet_packet_t* ArtNetRx::borrow() {
+    if (head == tail)
+        return nullptr;
+    return &slot[tail];
+}
+
+void ArtNetRx::release() {
+    if (head != tail)
+        tail = (tail + 1) % slots;
+}
+
+void ArtNetRx::pollReply(IPAddress ip) {
+    artnet_pollreply_t reply;
+    IPAddress local = WiFi.localIP();
+    uint16_t port = first;
+
+    // One reply per group of four port-addresses, new group on a SubNet change
+    for (uint8_t index = 1; port <= last; index++) {
+        memset(&reply, 0, sizeof(reply));
+        memcpy(reply.id, ARTNET_ID, sizeof(reply.id));
+        reply.opcode = ARTNET_OP_POLLREPLY;
+        for (uint8_t i = 0; i < 4; i++) {
+            reply.ip[i] = local[i];
+            reply.bind_ip[i] = local[i];
+        }
+        reply.port = ARTNET_DEFAULT_PORT;
+        reply.net = (port >> 8) & 0x7f;
+        reply.subnet = (port >> 4) & 0x0f;
+        reply.status1 = 0xd0;       // Front panel indicators normal, addresses set from the network
+        reply.style = ARTNET_STYLE_NODE;
+        reply.bind_index = index;
+        reply.status2 = ARTNET_STATUS2_V3;
+        WiFi.macAddress(reply.mac);
+        strncpy(reply.short_name, shortName.c_str(), sizeof(reply.short_name) - 1);
+        strncpy(reply.long_name, longName.c_str(), sizeof(reply.long_name) - 1);
+        snprintf(reply.node_report, sizeof(reply.node_report), "#0001 [%04u] OK",
+                static_cast<unsigned int>(stats.polls % 10000));
+
+        uint8_t ports = 0;
+        uint16_t group = port & 0x7ff0;
+        while (ports < 4 && port <= last && (port & 0x7ff0) == group) {
+            reply.port_types[ports] = ARTNET_PORT_OUTPUT;
+            reply.good_output[ports] = ARTNET_GOOD_OUTPUT;
+            reply.sw_out[ports] = port & 0x0f;
+            ports++;
+            port++;
+        }
+        reply.num_ports = htons(ports);
+
+        udp.writeTo(reinterpret_cast<uint8_t *>(&reply), sizeof(reply), ip, ARTNET_DEFAULT_PORT);
+    }
+}
+
+void ArtNetRx::parsePacket(AsyncUDPPacket _packet) {
+    const artnet_packet_t *packet = reinterpret_cast<const artnet_packet_t *>(_packet.data());
+    size_t length = _packet.length();
+
+    if (length < ARTNET_POLL_SIZE || memcmp(packet->id, ARTNET_ID, sizeof(ARTNET_ID))) {
+        stats.packet_errors++;
+        return;
+    }
+
+    switch (packet->opcode) {
+        case ARTNET_OP_POLL:
+            stats.polls++;
+            pollReply(_packet.remoteIP());
+            return;
+
+        case ARTNET_OP_DMX: {
+            uint16_t count = ntohs(packet->length);
+            if (length < ARTNET_HEADER_SIZE || count < 2 || count > 512 ||
+                    length < static_cast<size_t>(ARTNET_HEADER_SIZE + count)) {
+                stats.packet_errors++;
+                return;
+            }
+
+            // Drop port-addresses we don't listen to before they cost a slot
+            uint16_t port = packet->port_address & 0x7fff;
+            if (port < first || port > last) {
+                stats.filtered++;
+                return;
+            }
+            break;
+        }
+
+        case ARTNET_OP_SYNC:
+            if (length < ARTNET_SYNC_SIZE) {
+                stats.packet_errors++;
+                return;
+            }
+            break;
+
+        default:
+            // Valid Art-Net we have no use for
+            return;
+    }
+
+    uint8_t next = (head + 1) % slots;
+    if (next == tail) {
+        stats.overruns++;
+        return;
+    }
+
+    memcpy(slot[head].raw, packet, std::min(length, sizeof(artnet_packet_t)));
+    head = next;
+
+    if (isSync(packet))
+        stats.sync_packets++;
+    else
+        stats.num_packets++;
+    stats.last_clientIP = _packet.remoteIP();
+    stats.last_seen = millis();
+}
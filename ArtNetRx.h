@@ -0,0 +1,134 @@
+/*
+* ArtNetRx.h - Art-Net receiver for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef ARTNETRX_H_
+#define ARTNETRX_H_
+
+#include <ESPAsyncUDP.h>
+
+#define ARTNET_DEFAULT_PORT 6454
+#define ARTNET_PROTOCOL     14
+
+/* OpCodes, sent little endian */
+#define ARTNET_OP_POLL      0x2000
+#define ARTNET_OP_POLLREPLY 0x2100
+#define ARTNET_OP_DMX       0x5000
+#define ARTNET_OP_SYNC      0x5200
+
+#define ARTNET_HEADER_SIZE  18      /* ArtDmx up to the data */
+#define ARTNET_SYNC_SIZE    14      /* Size of an ArtSync */
+#define ARTNET_POLL_SIZE    14      /* Size of an ArtPoll */
+
+/* Art-Net has no sync universes, so ArtSync stands in for one E1.31 can't use */
+#define ARTNET_SYNC_ADDR    0xffff
+
+/* ArtDmx or ArtSync packet, multi-byte fields are as on the wire */
+typedef union {
+    struct {
+        uint8_t  id[8];             /* "Art-Net" */
+        uint16_t opcode;            /* Little endian */
+        uint16_t protocol;          /* Big endian */
+        uint8_t  sequence;          /* 0 when not used */
+        uint8_t  physical;
+        uint16_t port_address;      /* Little endian, Net:SubNet:Universe */
+        uint16_t length;            /* Big endian */
+        uint8_t  data[512];
+    } __attribute__((packed));
+
+    uint8_t raw[ARTNET_HEADER_SIZE + 512];
+} artnet_packet_t;
+
+/* Receiver statistics */
+typedef struct {
+    uint32_t    num_packets;    // ArtDmx packets accepted
+    uint32_t    sync_packets;   // ArtSync packets accepted
+    uint32_t    polls;          // ArtPolls answered
+    uint32_t    packet_errors;  // Packets that failed validation
+    uint32_t    filtered;       // Valid ArtDmx for port-addresses we don't listen to
+    uint32_t    seq_errors;     // Gaps in the sequence numbers
+    uint32_t    late;           // Stale ArtDmx dropped, inside E131_SEQ_WINDOW
+    uint32_t    overruns;       // Accepted packets dropped with every slot in use
+    IPAddress   last_clientIP;  // Source of the last accepted packet
+    uint32_t    last_seen;      // When the last packet was accepted, in millis
+} artnet_stats_t;
+
+/*
+* Same slot handoff as E131Rx. Port-address 0 lines up with E1.31
+* universe 1, so one universe window serves both protocols. ArtPoll is
+* answered straight from the UDP callback. Sequence numbers are tracked
+* per port-address with the E1.31 window, senders that leave them 0 don't
+* number packets.
+*/
+class ArtNetRx {
+ public:
+    artnet_stats_t  stats;      // Statistics tracker
+
+    explicit ArtNetRx(uint8_t slots);
+
+    /* Names are reported in ArtPollReply */
+    bool begin(String shortName, String longName);
+
+    /* Only port-addresses first..last are queued and reported, sync packets always are */
+    void setUniverses(uint16_t first, uint16_t last);
+
+    /*
+    * Check an ArtDmx's sequence number, false to drop it as stale. seqDiff
+    * is how far it was from the expected one, negative for late packets.
+    */
+    bool accept(const artnet_packet_t *packet, int8_t &seqDiff);
+
+    /* Oldest queued packet or nullptr, stays valid until release() */
+    artnet_packet_t* borrow();
+    void release();
+
+    inline bool isEmpty() {
+        return head == tail;
+    }
+
+    static inline bool isSync(const artnet_packet_t *packet) {
+        return packet->opcode == ARTNET_OP_SYNC;
+    }
+
+    /* E1.31 universe this ArtDmx is for */
+    static inline uint16_t universe(const artnet_packet_t *packet) {
+        return (packet->port_address & 0x7fff) + 1;
+    }
+
+    /* Channels in this ArtDmx */
+    static inline uint16_t channels(const artnet_packet_t *packet) {
+        return ntohs(packet->length);
+    }
+
+ private:
+    AsyncUDP        udp;
+    artnet_packet_t *slot;      // Packet slots
+    uint8_t         slots;      // Number of slots, one spare
+    volatile uint8_t    head;   // Next slot to fill
+    volatile uint8_t    tail;   // Next slot to hand out
+    uint16_t        first;      // First port-address we want
+    uint16_t        last;       // Last port-address we want
+    uint8_t         *sequence;  // Next expected sequence number of each, 0 for none yet
+    String          shortName;  // Node names for ArtPollReply
+    String          longName;
+
+    void parsePacket(AsyncUDPPacket _packet);
+    void pollReply(IPAddress ip);
+};
+
+#endif /* ARTNETRX_H_ */
@@ -0,0 +1,108 @@
+/*
+* DdpRx.cpp - DDP (Distributed Display Protocol) receiver for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include "DdpRx.h"
+
+DdpRx::DdpRx(uint8_t slots) {
+    // One spare so a full ring can be told from an empty one, allocated in begin()
+    this->slots = slots + 1;
+    slot = nullptr;
+    head = 0;
+    tail = 0;
+    sequence = 0;
+    pushIn = 0;
+    pushOut = 0;
+}
+
+bool DdpRx::begin() {
+    if (!slot) {
+        if (!(slot = static_cast<ddp_packet_t *>(malloc(slots * sizeof(ddp_packet_t)))))
+            return false;
+    }
+
+    if (!udp.listen(DDP_DEFAULT_PORT))
+        return false;
+
+    udp.onPacket(std::bind(&DdpRx::parsePacket, this, std::placeholders::_1));
+    return true;
+}
+
+ddp_packet_t* DdpRx::borrow() {
+    if (head == tail)
+        return nullptr;
+    return &slot[tail];
+}
+
+void DdpRx::release() {
+    if (head != tail) {
+        if (isPush(&slot[tail]))
+            pushOut++;
+        tail = (tail + 1) % slots;
+    }
+}
+
+void DdpRx::parsePacket(AsyncUDPPacket _packet) {
+    const ddp_packet_t *packet = reinterpret_cast<const ddp_packet_t *>(_packet.data());
+    size_t length = _packet.length();
+
+    if (length < DDP_HEADER_SIZE || (packet->flags & DDP_FLAG_VER_MASK) != DDP_FLAG_VER1) {
+        stats.packet_errors++;
+        return;
+    }
+
+    // Only data for the pixels, we have nothing to answer queries with
+    if ((packet->flags & (DDP_FLAG_QUERY | DDP_FLAG_REPLY)) ||
+            (packet->id != DDP_ID_DISPLAY && packet->id != DDP_ID_ALL &&
+            packet->id != DDP_ID_RESERVED))
+        return;
+
+    size_t header = DDP_HEADER_SIZE + ((packet->flags & DDP_FLAG_TIMECODE) ? DDP_TIMECODE_SIZE : 0);
+    uint16_t count = ntohs(packet->length);
+    if (count > DDP_MAX_DATA || length < header + count) {
+        stats.packet_errors++;
+        return;
+    }
+
+    uint8_t next = (head + 1) % slots;
+    if (next == tail) {
+        stats.overruns++;
+        return;
+    }
+
+    memcpy(slot[head].raw, packet, header + count);
+    if (isPush(packet))
+        pushIn++;
+    head = next;
+
+    // Sequence runs 1-15, 0 means the sender doesn't number packets
+    uint8_t seq = packet->sequence & 0x0f;
+    if (seq) {
+        if (sequence && seq != (sequence % 15) + 1)
+            stats.seq_errors++;
+        sequence = seq;
+    }
+
+    if (isPush(packet))
+        stats.push_packets++;
+
+    stats.num_packets++;
+    stats.last_clientIP = _packet.remoteIP();
+    stats.last_seen = millis();
+}
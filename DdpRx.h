@@ -0,0 +1,128 @@
+/*
+* DdpRx.h - DDP (Distributed Display Protocol) receiver for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef DDPRX_H_
+#define DDPRX_H_
+
+#include <ESPAsyncUDP.h>
+
+#define DDP_DEFAULT_PORT    4048
+
+#define DDP_HEADER_SIZE     10      /* Header without timecode */
+#define DDP_TIMECODE_SIZE   4       /* Extra header with DDP_FLAG_TIMECODE */
+#define DDP_MAX_DATA        1440    /* Largest payload senders use */
+
+/* Header flags */
+#define DDP_FLAG_VER_MASK   0xc0
+#define DDP_FLAG_VER1       0x40
+#define DDP_FLAG_TIMECODE   0x10
+#define DDP_FLAG_STORAGE    0x08
+#define DDP_FLAG_REPLY      0x04
+#define DDP_FLAG_QUERY      0x02
+#define DDP_FLAG_PUSH       0x01
+
+/* Destination IDs that address the pixels */
+#define DDP_ID_RESERVED     0
+#define DDP_ID_DISPLAY      1
+#define DDP_ID_ALL          255
+
+/* DDP packet, multi-byte fields are network order */
+typedef union {
+    struct {
+        uint8_t  flags;
+        uint8_t  sequence;          /* Low nibble, 0 when not used */
+        uint8_t  type;
+        uint8_t  id;
+        uint32_t offset;            /* Byte offset into the display */
+        uint16_t length;            /* Bytes of data */
+        uint8_t  data[DDP_TIMECODE_SIZE + DDP_MAX_DATA];
+    } __attribute__((packed));
+
+    uint8_t raw[DDP_HEADER_SIZE + DDP_TIMECODE_SIZE + DDP_MAX_DATA];
+} ddp_packet_t;
+
+/* Receiver statistics */
+typedef struct {
+    uint32_t    num_packets;    // Packets accepted
+    uint32_t    push_packets;   // Accepted packets with PUSH set
+    uint32_t    seq_errors;     // Gaps in the sequence numbers
+    uint32_t    packet_errors;  // Packets that failed validation
+    uint32_t    overruns;       // Accepted packets dropped with every slot in use
+    IPAddress   last_clientIP;  // Source of the last accepted packet
+    uint32_t    last_seen;      // When the last packet was accepted, in millis
+} ddp_stats_t;
+
+/*
+* Same slot handoff as E131Rx. There are no universes, each packet is a
+* byte range of the frame and PUSH marks the end of one, InputFrame::write()
+* latches them. The PUSH packets waiting in the queue are counted, so loop()
+* can skip to the newest whole frame when it falls behind. Queries and other
+* destinations are ignored.
+*/
+class DdpRx {
+ public:
+    ddp_stats_t     stats;      // Statistics tracker
+
+    explicit DdpRx(uint8_t slots);
+
+    bool begin();
+
+    /* Oldest queued packet or nullptr, stays valid until release() */
+    ddp_packet_t* borrow();
+    void release();
+
+    inline bool isEmpty() {
+        return head == tail;
+    }
+
+    /* PUSH packets queued, counting the borrowed one */
+    inline uint8_t pushQueued() {
+        return pushIn - pushOut;
+    }
+
+    static inline bool isPush(const ddp_packet_t *packet) {
+        return packet->flags & DDP_FLAG_PUSH;
+    }
+
+    static inline uint32_t offset(const ddp_packet_t *packet) {
+        return ntohl(packet->offset);
+    }
+
+    static inline uint16_t length(const ddp_packet_t *packet) {
+        return ntohs(packet->length);
+    }
+
+    static inline const uint8_t* data(const ddp_packet_t *packet) {
+        return packet->data + ((packet->flags & DDP_FLAG_TIMECODE) ? DDP_TIMECODE_SIZE : 0);
+    }
+
+ private:
+    AsyncUDP        udp;
+    ddp_packet_t    *slot;      // Packet slots
+    uint8_t         slots;      // Number of slots, one spare
+    volatile uint8_t    head;   // Next slot to fill
+    volatile uint8_t    tail;   // Next slot to hand out
+    uint8_t         sequence;   // Last sequence number seen
+    volatile uint8_t    pushIn;     // PUSH packets queued, only parsePacket() writes it
+    volatile uint8_t    pushOut;    // PUSH packets released, only release() writes it
+
+    void parsePacket(AsyncUDPPacket _packet);
+};
+
+#endif /* DDPRX_H_ */
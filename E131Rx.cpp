@@ -0,0 +1,163 @@
+/*
+* E131Rx.cpp - E1.31 (sACN) receiver for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <lwip/ip_addr.h>
+#include <lwip/igmp.h>
+#include "E131Rx.h"
+
+static const uint8_t ACN_ID[12] = {
+    0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00
+};
+
+E131Rx::E131Rx(uint8_t slots) {
+    // One spare so a full ring can be told from an empty one
+    slot = static_cast<e131_packet_t *>(malloc((slots + 1) * sizeof(e131_packet_t)));
+    arrival = static_cast<uint32_t *>(malloc((slots + 1) * sizeof(uint32_t)));
+    if (slot && arrival)
+        this->slots = slots + 1;
+    else
+        this->slots = 1;
+
+    head = 0;
+    tail = 0;
+    setUniverses(1, 1);
+}
+
+bool E131Rx::begin(e131_listen_t type, uint16_t universe, uint8_t count) {
+    bool success = false;
+
+    multicast = (type == E131_MULTICAST);
+    syncJoined = 0;
+
+    if (multicast) {
+        if (udp.listenMulticast(groupAddress(universe), E131_DEFAULT_PORT)) {
+            for (uint8_t i = 1; i < count; i++)
+                joinUniverse(universe + i);
+            success = true;
+        }
+    } else {
+        success = udp.listen(E131_DEFAULT_PORT);
+    }
+
+    if (success)
+        udp.onPacket(std::bind(&E131Rx::parsePacket, this, std::placeholders::_1));
+
+    return success;
+}
+
+void E131Rx::setUniverses(uint16_t first, uint16_t last) {
+    uniFirst = first;
+    uniLast = last;
+    memset(wanted, 0xff, sizeof(wanted));
+}
+
+void E131Rx::ignoreUniverse(uint16_t universe) {
+    if (universe < uniFirst || universe > uniLast || universe - uniFirst >= E131_UNIVERSES)
+        return;
+    uint16_t idx = universe - uniFirst;
+    wanted[idx / 8] &= ~(1 << (idx % 8));
+}
+
+void E131Rx::joinUniverse(uint16_t universe) {
+    ip4_addr_t ifaddr;
+    ip4_addr_t multicast_addr;
+
+    ifaddr.addr = static_cast<uint32_t>(WiFi.localIP());
+    multicast_addr.addr = static_cast<uint32_t>(groupAddress(universe));
+    igmp_joingroup(&ifaddr, &multicast_addr);
+}
+
+e131_packet_t* E131Rx::borrow() {
+    if (head == tail)
+        return nullptr;
+    return &slot[tail];
+}
+
+void E131Rx::release() {
+    if (head != tail)
+        tail = (tail + 1) % slots;
+}
+
+void E131Rx::parsePacket(AsyncUDPPacket _packet) {
+    const e131_packet_t *packet = reinterpret_cast<const e131_packet_t *>(_packet.data());
+    size_t length = _packet.length();
+
+    // Root layer
+    if (length < E131_SYNC_SIZE ||
+            packet->preamble_size != htons(E131_PREAMBLE_SIZE) ||
+            packet->postamble_size != htons(E131_POSTAMBLE_SIZE) ||
+            memcmp(packet->acn_id, ACN_ID, sizeof(ACN_ID))) {
+        stats.packet_errors++;
+        return;
+    }
+
+    if (packet->root_vector == htonl(VECTOR_ROOT_E131_DATA)) {
+        // Framing and DMP layer
+        uint16_t count = ntohs(packet->property_value_count);
+        if (length < E131_DATA_MIN_SIZE ||
+                packet->frame_vector != htonl(VECTOR_E131_DATA_PACKET) ||
+                packet->dmp_vector != VECTOR_DMP_SET_PROPERTY ||
+                packet->type != E131_DMP_TYPE ||
+                packet->first_address != 0 ||
+                packet->address_increment != htons(1) ||
+                count < 1 || count > 513 ||
+                length < static_cast<size_t>(E131_DATA_MIN_SIZE - 1 + count)) {
+            stats.packet_errors++;
+            return;
+        }
+
+        // Drop universes we don't listen to before they cost a slot
+        uint16_t universe = ntohs(packet->universe);
+        if (!isWanted(universe)) {
+            stats.filtered++;
+            return;
+        }
+
+        // Sync packets go to their own multicast group
+        uint16_t syncAddr = ntohs(packet->sync_address);
+        if (multicast && syncAddr && syncAddr != syncJoined) {
+            joinUniverse(syncAddr);
+            syncJoined = syncAddr;
+        }
+    } else if (packet->root_vector == htonl(VECTOR_ROOT_E131_EXTENDED)) {
+        if (packet->sync_vector != htonl(VECTOR_E131_EXTENDED_SYNCHRONIZATION)) {
+            stats.packet_errors++;
+            return;
+        }
+    } else {
+        stats.packet_errors++;
+        return;
+    }
+
+    uint8_t next = (head + 1) % slots;
+    if (next == tail) {
+        stats.overruns++;
+        return;
+    }
+
+    memcpy(slot[head].raw, packet, std::min(length, sizeof(e131_packet_t)));
+    arrival[head] = micros();
+    head = next;
+
+    stats.num_packets++;
+    stats.last_clientIP = _packet.remoteIP();
+    stats.last_seen = millis();
+}
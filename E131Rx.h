@@ -0,0 +1,171 @@
+/*
+* E131Rx.h - E1.31 (sACN) receiver for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef E131RX_H_
+#define E131RX_H_
+
+#include <ESPAsyncUDP.h>
+
+#define E131_DEFAULT_PORT   5568
+
+/* Root layer */
+#define E131_PREAMBLE_SIZE          0x0010
+#define E131_POSTAMBLE_SIZE         0x0000
+#define VECTOR_ROOT_E131_DATA       0x00000004
+#define VECTOR_ROOT_E131_EXTENDED   0x00000008
+
+/* Framing layer */
+#define VECTOR_E131_DATA_PACKET             0x00000002
+#define VECTOR_E131_EXTENDED_SYNCHRONIZATION 0x00000001
+
+/* DMP layer */
+#define VECTOR_DMP_SET_PROPERTY     0x02
+#define E131_DMP_TYPE               0xa1
+
+#define E131_SEQ_WINDOW     20      /* Packets this far behind are stale, further back the source restarted */
+#define E131_UNIVERSES      256     /* Universes setUniverses() can span */
+
+#define E131_SYNC_SIZE      49      /* Size of a sync packet */
+#define E131_DATA_MIN_SIZE  126     /* Data packet with just the start code */
+
+enum e131_listen_t {
+    E131_UNICAST,
+    E131_MULTICAST
+};
+
+/* E1.31 data or sync packet, multi-byte fields are network order */
+typedef union {
+    struct {
+        /* Root Layer */
+        uint16_t preamble_size;
+        uint16_t postamble_size;
+        uint8_t  acn_id[12];
+        uint16_t root_flength;
+        uint32_t root_vector;
+        uint8_t  cid[16];
+
+        /* Frame Layer */
+        uint16_t frame_flength;
+        uint32_t frame_vector;
+        uint8_t  source_name[64];
+        uint8_t  priority;
+        uint16_t sync_address;
+        uint8_t  sequence_number;
+        uint8_t  options;
+        uint16_t universe;
+
+        /* DMP Layer */
+        uint16_t dmp_flength;
+        uint8_t  dmp_vector;
+        uint8_t  type;
+        uint16_t first_address;
+        uint16_t address_increment;
+        uint16_t property_value_count;
+        uint8_t  property_values[513];
+    } __attribute__((packed));
+
+    /* Sync packets share the root layer and little else */
+    struct {
+        uint8_t  sync_root[38];
+        uint16_t sync_flength;
+        uint32_t sync_vector;
+        uint8_t  sync_sequence;
+        uint16_t sync_universe;     /* Sync address being triggered */
+        uint16_t sync_reserved;
+    } __attribute__((packed));
+
+    uint8_t raw[638];
+} e131_packet_t;
+
+/* Receiver statistics */
+typedef struct {
+    uint32_t    num_packets;    // Packets accepted
+    uint32_t    packet_errors;  // Packets that failed validation
+    uint32_t    filtered;       // Valid packets for universes we don't listen to
+    uint32_t    overruns;       // Accepted packets dropped with every slot in use
+    IPAddress   last_clientIP;  // Source of the last accepted packet
+    uint32_t    last_seen;      // When the last packet was accepted, in millis
+} e131_stats_t;
+
+/*
+* Packets are validated and filtered on universe in the UDP callback, so
+* only wanted ones take a slot. A patch table can leave universes in the
+* window that map nowhere, a bitmap drops those too. loop() borrows the
+* oldest slot in place and releases it once mapped, no second copy.
+*/
+class E131Rx {
+ public:
+    e131_stats_t    stats;      // Statistics tracker
+
+    explicit E131Rx(uint8_t slots);
+
+    bool begin(e131_listen_t type, uint16_t universe = 1, uint8_t count = 1);
+
+    /* Only packets for universes first..last are queued, sync packets always are */
+    void setUniverses(uint16_t first, uint16_t last);
+
+    /* Drop packets for universe as well, it's in the window but unused */
+    void ignoreUniverse(uint16_t universe);
+
+    /* Oldest queued packet or nullptr, stays valid until release() */
+    e131_packet_t* borrow();
+    void release();
+
+    /* When the borrowed packet arrived, in micros */
+    inline uint32_t stamp() {
+        return arrival[tail];
+    }
+
+    inline bool isEmpty() {
+        return head == tail;
+    }
+
+    static inline bool isSync(const e131_packet_t *packet) {
+        return packet->root_vector == htonl(VECTOR_ROOT_E131_EXTENDED);
+    }
+
+ private:
+    AsyncUDP        udp;
+    e131_packet_t   *slot;      // Packet slots
+    uint32_t        *arrival;   // Arrival time of each slot, micros
+    uint8_t         slots;      // Number of slots
+    volatile uint8_t    head;   // Next slot to fill
+    volatile uint8_t    tail;   // Next slot to hand out
+    uint16_t        uniFirst;   // First universe we want
+    uint16_t        uniLast;    // Last universe we want
+    uint8_t         wanted[E131_UNIVERSES / 8];    // Universes in the window we want, bitmap
+    bool            multicast;  // Listening on multicast groups
+    uint16_t        syncJoined; // Sync universe whose multicast group we joined
+
+    void parsePacket(AsyncUDPPacket _packet);
+    void joinUniverse(uint16_t universe);
+
+    inline bool isWanted(uint16_t universe) {
+        if (universe < uniFirst || universe > uniLast)
+            return false;
+        uint16_t idx = universe - uniFirst;
+        return idx >= E131_UNIVERSES || (wanted[idx / 8] & (1 << (idx % 8)));
+    }
+
+    static inline IPAddress groupAddress(uint16_t universe) {
+        return IPAddress(239, 255, (universe >> 8) & 0xff, universe & 0xff);
+    }
+};
+
+#endif /* E131RX_H_ */
@@ -41,13 +41,24 @@ const char BUILD_DATE[] = __DATE__;
 #endif
 
 #include "EffectEngine.h"
+#include "InputFrame.h"
+#include "UniverseMap.h"
 
 #define HTTP_PORT       80      /* Default web server port */
 #define MQTT_PORT       1883    /* Default MQTT port */
 #define DATA_PIN        2       /* Pixel output - GPIO2 (D4 on NodeMCU) */
 #define UNIVERSE_MAX    512     /* Max channels in a DMX Universe */
-#define PIXEL_LIMIT     1360    /* Total pixel limit - 40.85ms for 8 universes */
+#if defined(ESPS_ENABLE_DUAL_OUTPUT)
+#define PIXEL_LIMIT     2720    /* Total RGB pixel timing limit - 1360 per output in parallel, heap permitting */
+#else
+#define PIXEL_LIMIT     1360    /* Total RGB pixel timing limit - 40.85ms for 8 universes */
+#endif
+#define HEAP_BUDGET     40960   /* Heap left for receive slots and frame buffers once WiFi and the web server are up */
+#define APA102_LIMIT    2048    /* Pixel limit for clocked pixels - bound by RAM */
 #define RENARD_LIMIT    2048    /* Channel limit for serial outputs */
+#define E131_BUFFERS    10      /* Packet slots E131Rx can queue for loop() */
+#define ARTNET_BUFFERS  10      /* Packet slots ArtNetRx can queue for loop(), allocated when enabled */
+#define DDP_BUFFERS     4       /* Packet slots DdpRx can queue for loop(), allocated when enabled */
 #define E131_TIMEOUT    1000    /* Force refresh every second an E1.31 packet is not seen */
 #define CLIENT_TIMEOUT  15      /* In station/client mode try to connection for 15 seconds */
 #define AP_TIMEOUT      60      /* In AP mode, wait 60 seconds for a connection or reboot */
@@ -63,7 +74,6 @@ const char BUILD_DATE[] = __DATE__;
 
 // Configuration file params
 #define CONFIG_MAX_SIZE 4096    /* Sanity limit for config file */
-
 // Pixel Types
 class DevCap {
  public:
@@ -115,6 +125,7 @@ typedef struct {
     bool effect_reverse;
     bool effect_mirror;
     bool effect_allleds;
+    bool effect_white;      /* Extract white for RGBW pixels */
     bool effect_startenabled;
     bool effect_idleenabled;
     uint16_t effect_idletimeout;
@@ -144,6 +155,11 @@ typedef struct {
     uint16_t    channel_start;  /* Channel to start listening at - 1 based */
     uint16_t    channel_count;  /* Number of channels */
     bool        multicast;      /* Enable multicast listener */
+    bool        e131_merge;     /* HTP merge of equal priority sources */
+    bool        artnet;         /* Enable Art-Net listener on the same universes */
+    bool        ddp;            /* Enable DDP listener */
+    patch_t     patch[PATCH_MAX];   /* Channel patch table, replaces channel_start and universe_limit when set */
+    uint8_t     patch_count;    /* Entries in the patch table */
 
 #if defined(ESPS_MODE_PIXEL)
     /* Pixels */
@@ -153,6 +169,11 @@ typedef struct {
     uint16_t    groupSize;      /* Group size - 1 = no grouping */
     float       gammaVal;       /* gamma value to use */
     float       briteVal;       /* brightness lto use */
+    uint16_t    pixel_split;    /* Pixels on the first output, 0 = half - dual output only */
+    PixelColor  pixel_color2;   /* Pixel color order of the second output */
+    bool        pixel_dither;   /* Temporal dithering of the gamma table */
+    uint32_t    pixel_spi_clock;    /* SPI clock in Hz for clocked pixels */
+    uint8_t     pixel_spi_bright;   /* APA102 global brightness 1-31 */
 #elif defined(ESPS_MODE_SERIAL)
     /* Serial */
     SerialType  serial_type;    /* Serial type */
@@ -29,10 +29,14 @@ const char passphrase[] = "ENTER_PASSPHRASE_HERE";
 /*         END - Configuration           */
 /*****************************************/
 
-#include <ESPAsyncE131.h>
 #include <Hash.h>
 #include <SPI.h>
 #include "ESPixelStick.h"
+#include "E131Rx.h"
+#include "SourceTable.h"
+#include "ArtNetRx.h"
+#include "DdpRx.h"
+#include "UniverseStats.h"
 #include "EFUpdate.h"
 #include "wshandler.h"
 #include "gamma.h"
@@ -88,14 +92,19 @@ char m_msg_buffer[MSG_BUFFER_SIZE];
 // Configuration file
 const char CONFIG_FILE[] = "/config.json";
 
-ESPAsyncE131        e131(10);       // ESPAsyncE131 with X buffers
+E131Rx              e131(E131_BUFFERS); // E1.31 receiver with X slots
+InputFrame          input;          // E1.31 back buffer
+SourceTable         sources;        // E1.31 senders
+ArtNetRx            artnet(ARTNET_BUFFERS); // Art-Net receiver with X slots
+DdpRx               ddp(DDP_BUFFERS);       // DDP receiver with X slots
 config_t            config;         // Current configuration
-uint32_t            *seqError;      // Sequence error tracking for each universe
+UniverseStats       uniStats;       // Loss, jitter and latency tracking for each universe
+uint32_t            pktStamp;       // Arrival of the packet being ingested, micros
 uint16_t            uniLast = 1;    // Last Universe to listen for
 bool                reboot = false; // Reboot flag
 AsyncWebServer      web(HTTP_PORT); // Web Server
 AsyncWebSocket      ws("/ws");      // Web Socket Plugin
-uint8_t             *seqTracker;    // Current sequence numbers for each Universe */
+UniverseMap         uniMap;         // Where each Universe lands in the frame
 uint32_t            lastUpdate;     // Update timeout tracker
 WiFiEventHandler    wifiConnectHandler;     // WiFi connect handler
 WiFiEventHandler    wifiDisconnectHandler;  // WiFi disconnect handler
@@ -175,6 +184,9 @@ void setup() {
     if (config.hostname)
         WiFi.hostname(config.hostname);
 
+    // Load the compiled effect program, if one was uploaded
+    effects.loadProgram();
+
 #if defined (ESPS_MODE_PIXEL)
     pixels.setPin(DATA_PIN);
     updateConfig();
@@ -266,6 +278,26 @@ void setup() {
         }
     }
 
+    // Setup Art-Net
+    if (config.artnet) {
+        if (artnet.begin(config.id, "ESPixelBoard " + config.hostname)) {
+            LOG_PORT.print(F("- Art-Net port: "));
+            LOG_PORT.println(ARTNET_DEFAULT_PORT);
+        } else {
+            LOG_PORT.println(F("*** ART-NET INIT FAILED ****"));
+        }
+    }
+
+    // Setup DDP
+    if (config.ddp) {
+        if (ddp.begin()) {
+            LOG_PORT.print(F("- DDP port: "));
+            LOG_PORT.println(DDP_DEFAULT_PORT);
+        } else {
+            LOG_PORT.println(F("*** DDP INIT FAILED ****"));
+        }
+    }
+
    /* check for raw packets on port 2801 */
 #if defined(ESPS_ENABLE_UDPRAW)
     if (config.udp_enabled) {
@@ -552,6 +584,16 @@ void onMqttMessage(char* topic, char* payload,
             effects.setAllLeds(root["allleds"]);
         }
 
+        // Overlay layers, an unknown or Disabled effect clears the layer
+        if (root.containsKey("layer")) {
+            JsonObject& layer = root["layer"];
+            String effect = layer.containsKey("effect") ? layer["effect"].as<String>() : "Disabled";
+            uint8_t opacity = layer.containsKey("opacity") ? layer["opacity"].as<uint8_t>() : 255;
+            effects.setLayer(layer["index"], effect,
+                    { layer["color"]["r"], layer["color"]["g"], layer["color"]["b"] },
+                    opacity, EffectEngine::getBlendMode(layer["blend"].as<String>()));
+        }
+
         // Set data source based on state - Fall back to E131 when off
         if (stateOn) {
             config.ds = DataSource::MQTT;
@@ -707,6 +749,67 @@ void initWeb() {
 //
 /////////////////////////////////////////////////////////
 
+/*
+* Heap the config needs with channels of output: the receive slots, the
+* output's buffers, the input frame, HTP merge buffers for every source
+* and the effect frame with its overlay layers and E1.31 base. Small
+* per-universe tables aren't counted.
+*/
+uint32_t bufferHeap(uint16_t channels) {
+    uint32_t heap = (E131_BUFFERS + 1) * (sizeof(e131_packet_t) + sizeof(uint32_t));
+    if (config.artnet)
+        heap += ARTNET_BUFFERS * sizeof(artnet_packet_t);
+    if (config.ddp)
+        heap += DDP_BUFFERS * sizeof(ddp_packet_t);
+
+#if defined(ESPS_MODE_PIXEL)
+    uint16_t pixels = channels / pixelChannels(config.pixel_color);
+    uint16_t leds = pixels / std::max(config.groupSize, static_cast<uint16_t>(1));
+    heap += 2 * channels;                   // Pixel data and async copy
+    if (config.pixel_dither && config.pixel_type == PixelType::WS2811)
+        heap += 2 * channels;               // Dither error and output
+    if (config.groupSize > 1 || config.zigSize)
+        heap += pixels * sizeof(uint16_t);  // Remap
+    if (config.pixel_type == PixelType::APA102)
+        heap += APA102_SIZE(pixels);
+#elif defined(ESPS_MODE_SERIAL)
+    uint16_t leds = channels / 3;
+    heap += 2 * channels + 2;               // Serial data and async copy
+#endif
+
+    heap += channels;                       // Input frame
+    if (config.e131_merge)
+        heap += SOURCE_MAX * channels;
+    heap += (1 + EFFECT_LAYERS) * leds * sizeof(CRGB) + channels;
+    return heap;
+}
+
+/* Cut channel_count back in whole steps until bufferHeap() fits HEAP_BUDGET */
+void fitHeap(uint8_t step) {
+    uint32_t heap = bufferHeap(config.channel_count);
+    if (heap <= HEAP_BUDGET)
+        return;
+
+    // Close to linear past the fixed part, so scale first and then trim
+    uint32_t fixed = bufferHeap(0);
+    uint16_t channels = 0;
+    if (fixed < HEAP_BUDGET)
+        channels = static_cast<uint64_t>(config.channel_count) * (HEAP_BUDGET - fixed) / (heap - fixed);
+    channels = channels / step * step;
+    while (channels > step && bufferHeap(channels) > HEAP_BUDGET)
+        channels -= step;
+    channels = std::max(channels, static_cast<uint16_t>(step));
+
+    LOG_PORT.print(F("*** Channel count "));
+    LOG_PORT.print(config.channel_count);
+    LOG_PORT.print(F(" needs "));
+    LOG_PORT.print(heap);
+    LOG_PORT.print(F(" bytes of heap, cut to "));
+    LOG_PORT.print(channels);
+    LOG_PORT.println(F(" ***"));
+    config.channel_count = channels;
+}
+
 // Configuration Validations
 void validateConfig() {
     // E1.31 Limits
@@ -746,27 +849,53 @@ void validateConfig() {
     config.devmode.MPIXEL = true;
     config.devmode.MSERIAL = false;
 
-    // Generic channel limits for pixels
-    if (config.channel_count % 3)
-        config.channel_count = (config.channel_count / 3) * 3;
+    // GECE bulbs are always RGB, only WS2811 carries a white channel
+    if (config.pixel_type == PixelType::GECE ||
+            (config.pixel_type != PixelType::WS2811 && pixelChannels(config.pixel_color) > 3))
+        config.pixel_color = PixelColor::RGB;
 
-    if (config.channel_count > PIXEL_LIMIT * 3)
-        config.channel_count = PIXEL_LIMIT * 3;
-    else if (config.channel_count < 1)
-        config.channel_count = 1;
+    // Both outputs share one buffer layout
+    uint8_t stride = pixelChannels(config.pixel_color);
+    if (pixelChannels(config.pixel_color2) != stride)
+        config.pixel_color2 = config.pixel_color;
+
+    // Generic channel limits for pixels, refresh time goes by channel so
+    // the limit does too
+    if (config.channel_count % stride)
+        config.channel_count = (config.channel_count / stride) * stride;
+
+    uint16_t limit = (config.pixel_type == PixelType::APA102) ? APA102_LIMIT * 3 : PIXEL_LIMIT * 3;
+    if (config.channel_count > limit)
+        config.channel_count = (limit / stride) * stride;
+    else if (config.channel_count < stride)
+        config.channel_count = stride;
+    fitHeap(stride);
+
+    if (config.pixel_split > config.channel_count / stride)
+        config.pixel_split = 0;
 
-    if (config.groupSize > config.channel_count / 3)
-        config.groupSize = config.channel_count / 3;
+    if (config.groupSize > config.channel_count / stride)
+        config.groupSize = config.channel_count / stride;
     else if (config.groupSize < 1)
         config.groupSize = 1;
 
     // GECE Limits
     if (config.pixel_type == PixelType::GECE) {
-        config.pixel_color = PixelColor::RGB;
         if (config.channel_count > 63 * 3)
             config.channel_count = 63 * 3;
     }
 
+    // APA102 Limits
+    if (config.pixel_type == PixelType::APA102) {
+        if (!config.pixel_spi_clock)
+            config.pixel_spi_clock = APA102_DEFAULT_CLOCK;
+        else if (config.pixel_spi_clock > APA102_MAX_CLOCK)
+            config.pixel_spi_clock = APA102_MAX_CLOCK;
+
+        if (!config.pixel_spi_bright || config.pixel_spi_bright > APA102_MAX_BRIGHTNESS)
+            config.pixel_spi_bright = APA102_MAX_BRIGHTNESS;
+    }
+
     // Default gamma value
     if (config.gammaVal <= 0) {
         config.gammaVal = 2.2;
@@ -789,6 +918,7 @@ void validateConfig() {
 
     if (config.serial_type == SerialType::DMX512 && config.channel_count > UNIVERSE_MAX)
         config.channel_count = UNIVERSE_MAX;
+    fitHeap(1);
 
     // Baud rate check
     if (config.baudrate > BaudRate::BR_460800)
@@ -797,6 +927,24 @@ void validateConfig() {
         config.baudrate = BaudRate::BR_57600;
 #endif
 
+    // Patch table, drop entries that can't map and clip the rest to the
+    // universe and the output
+    uint8_t patches = 0;
+    for (uint8_t i = 0; i < config.patch_count && i < PATCH_MAX; i++) {
+        patch_t patch = config.patch[i];
+        if (patch.universe < config.universe ||
+                patch.universe >= config.universe + PATCH_UNIVERSES ||
+                patch.channel < 1 || patch.channel > UNIVERSE_MAX ||
+                patch.offset >= config.channel_count)
+            continue;
+
+        patch.length = std::min(patch.length, static_cast<uint16_t>(UNIVERSE_MAX - patch.channel + 1));
+        patch.length = std::min(patch.length, static_cast<uint16_t>(config.channel_count - patch.offset));
+        if (patch.length)
+            config.patch[patches++] = patch;
+    }
+    config.patch_count = patches;
+
     if (config.effect_speed < 1)
         config.effect_speed = 1;
     if (config.effect_speed > 10)
@@ -831,37 +979,162 @@ void validateConfig() {
     }
 }
 
+/* Map one E1.31 packet into the input frame */
+void ingestE131(e131_packet_t &packet) {
+    uint16_t universe = htons(packet.universe);
+    uint8_t *data = packet.property_values + 1;
+    //LOG_PORT.print(universe);
+    //LOG_PORT.println(packet.sequence_number);
+    if ((universe >= config.universe) && (universe <= uniLast)) {
+        // Universe offset, source arbitration and sequence tracking
+        uint8_t uniOffset = (universe - config.universe);
+        int8_t seqDiff;
+        int8_t src = sources.accept(packet, uniOffset, seqDiff);
+        if (src < 0) {
+            uniStats.dropped(uniOffset, seqDiff);
+            return;
+        }
+        uniStats.packet(uniOffset, seqDiff, pktStamp);
+
+        ingestUniverse(uniOffset, data, htons(packet.property_value_count) - 1,
+                htons(packet.sync_address), src);
+    }
+}
+
+/* Map one Art-Net packet into the input frame */
+void ingestArtNet(artnet_packet_t &packet) {
+    uint16_t universe = ArtNetRx::universe(&packet);
+
+    if ((universe >= config.universe) && (universe <= uniLast)) {
+        uint8_t uniOffset = universe - config.universe;
+        int8_t seqDiff;
+        if (!artnet.accept(&packet, seqDiff)) {
+            uniStats.dropped(uniOffset, seqDiff);
+            return;
+        }
+        uniStats.packet(uniOffset, seqDiff, pktStamp);
+        ingestUniverse(uniOffset, packet.data,
+                ArtNetRx::channels(&packet), ARTNET_SYNC_ADDR, -1);
+    }
+}
+
+/* Write one DDP packet into the input frame */
+void ingestDDP(ddp_packet_t &packet) {
+    if (input.write(DdpRx::offset(&packet), DdpRx::data(&packet),
+            DdpRx::length(&packet), DdpRx::isPush(&packet)))
+        commitInput();
+}
+
+/* Write one universe of channel data into the input frame, src -1 when it's not E1.31 */
+void ingestUniverse(uint8_t uniOffset, const uint8_t *data, uint16_t channels,
+        uint16_t syncAddr, int8_t src) {
+    // Universes in the window without a patch aren't part of the frame
+    if (!uniMap.isMapped(uniOffset))
+        return;
+
+    // Latch the last frame first if this universe starts a new one. Merged
+    // sources only add their data, the holder's packets pace the frame.
+    bool lead = sources.leads(src, uniOffset);
+    if (lead && input.start(uniOffset))
+        commitInput();
+
+    // Copy what the packet has of each slice
+    if (channels > UNIVERSE_MAX)
+        channels = UNIVERSE_MAX;
+    uint16_t count;
+    const uni_slice_t *slices = uniMap.slices(uniOffset, count);
+    for (uint16_t i = 0; i < count; i++) {
+        const uni_slice_t &slice = slices[i];
+        if (channels > slice.src) {
+            uint16_t len = std::min(slice.len, static_cast<uint16_t>(channels - slice.src));
+            sources.write(src, uniOffset, input.getData(), data + slice.src, slice.dst, len);
+        }
+    }
+
+    if (lead && input.received(uniOffset, syncAddr))
+        commitInput();
+}
+
+/* Hand a latched E1.31 frame to the output */
+void commitInput() {
+    uniStats.latched(pktStamp);
+    if (effects.hasLayers()) {
+        effects.setBase(input.getData(), input.getSize());
+        return;
+    }
+#if defined(ESPS_MODE_PIXEL)
+    pixels.setData(input.getData(), input.getSize());
+#elif defined(ESPS_MODE_SERIAL)
+    serial.setData(input.getData(), input.getSize());
+#endif
+}
+
 void updateConfig() {
     // Validate first
     validateConfig();
 
     // Find the last universe we should listen for
-    uint16_t span = config.channel_start + config.channel_count - 1;
-    if (span % config.universe_limit)
-        uniLast = config.universe + span / config.universe_limit;
-    else
-        uniLast = config.universe + span / config.universe_limit - 1;
+    if (config.patch_count) {
+        uniLast = config.universe;
+        for (uint8_t i = 0; i < config.patch_count; i++)
+            uniLast = std::max(uniLast, config.patch[i].universe);
+    } else {
+        uint16_t span = config.channel_start + config.channel_count - 1;
+        if (span % config.universe_limit)
+            uniLast = config.universe + span / config.universe_limit;
+        else
+            uniLast = config.universe + span / config.universe_limit - 1;
+    }
 
-    // Setup the sequence error tracker
+    // Setup the per universe stats
     uint8_t uniTotal = (uniLast + 1) - config.universe;
 
-    if (seqTracker) free(seqTracker);
-    if ((seqTracker = static_cast<uint8_t *>(malloc(uniTotal))))
-        memset(seqTracker, 0x00, uniTotal);
+    uniStats.begin(uniTotal);
 
-    if (seqError) free(seqError);
-    if ((seqError = static_cast<uint32_t *>(malloc(uniTotal * 4))))
-        memset(seqError, 0x00, uniTotal * 4);
+    // Map each universe onto the frame once, instead of per packet
+    uint8_t uniPatched;
+    if (config.patch_count)
+        uniPatched = uniMap.begin(config.patch, config.patch_count, config.universe, uniTotal);
+    else
+        uniPatched = uniMap.begin(config.channel_start, config.universe_limit,
+                config.channel_count, uniTotal);
+
+    // Only queue the universes we map
+    e131.setUniverses(config.universe, uniLast);
+    for (uint8_t u = 0; u < uniTotal; u++) {
+        if (!uniMap.isMapped(u))
+            e131.ignoreUniverse(config.universe + u);
+    }
+    artnet.setUniverses(config.universe - 1, uniLast - 1);
 
     // Zero out packet stats
     e131.stats.num_packets = 0;
 
+    // Universes are assembled here and latched as whole frames
+    input.begin(config.channel_count, uniTotal, uniPatched);
+
+    // Sources are tracked per universe, sequence numbers with them
+    sources.begin(config.channel_count, uniTotal, config.e131_merge);
+
+#if defined(ESPS_SUPPORT_PWM)
+    // Hand PWM back any pins the last pixel type had, before this one takes its own
+    updatePWMMask();
+#endif
+
     // Initialize for our pixel type
 #if defined(ESPS_MODE_PIXEL)
-    pixels.begin(config.pixel_type, config.pixel_color, config.channel_count / 3);
+    uint8_t stride = pixelChannels(config.pixel_color);
+    pixels.begin(config.pixel_type, config.pixel_color, config.channel_count / stride);
     pixels.setGroup(config.groupSize, config.zigSize);
-    updateGammaTable(config.gammaVal, config.briteVal);
-    effects.begin(&pixels, config.channel_count / 3 / config.groupSize);
+#if defined(ESPS_ENABLE_DUAL_OUTPUT)
+    if (config.pixel_type == PixelType::WS2811)
+        pixels.setSplit(config.pixel_split, config.pixel_color2);
+#endif
+    if (config.pixel_type == PixelType::APA102)
+        pixels.setSPI(config.pixel_spi_clock, config.pixel_spi_bright);
+    pixels.setDither(config.pixel_dither);
+    updateGammaTable(config.gammaVal, config.briteVal, pixels.isDithering());
+    effects.begin(&pixels, config.channel_count / stride / config.groupSize, stride);
 
 #elif defined(ESPS_MODE_SERIAL)
     serial.begin(&SEROUT_PORT, config.serial_type, config.channel_count, config.baudrate);
@@ -938,6 +1211,8 @@ void dsEffectConfig(JsonObject &json) {
         config.effect_name = effectsJson["name"].as<String>();
         config.effect_mirror = effectsJson["mirror"];
         config.effect_allleds = effectsJson["allleds"];
+        if (effectsJson.containsKey("white"))
+            config.effect_white = effectsJson["white"];
         config.effect_reverse = effectsJson["reverse"];
         if (effectsJson.containsKey("speed"))
             config.effect_speed = effectsJson["speed"];
@@ -968,6 +1243,21 @@ void dsDeviceConfig(JsonObject &json) {
         config.channel_start = json["e131"]["channel_start"];
         config.channel_count = json["e131"]["channel_count"];
         config.multicast = json["e131"]["multicast"];
+        config.e131_merge = json["e131"]["merge"];
+        config.artnet = json["e131"]["artnet"];
+        config.ddp = json["e131"]["ddp"];
+
+        // Patches are [universe, channel, offset, length]
+        JsonArray &patchJson = json["e131"]["patch"];
+        config.patch_count = 0;
+        for (uint8_t i = 0; i < patchJson.size() && i < PATCH_MAX; i++) {
+            JsonArray &p = patchJson[i];
+            config.patch[i].universe = p[0];
+            config.patch[i].channel = p[1];
+            config.patch[i].offset = p[2];
+            config.patch[i].length = p[3];
+            config.patch_count++;
+        }
     }
 
     // MQTT
@@ -993,6 +1283,16 @@ void dsDeviceConfig(JsonObject &json) {
         config.zigSize = json["pixel"]["zigSize"];
         config.gammaVal = json["pixel"]["gammaVal"];
         config.briteVal = json["pixel"]["briteVal"];
+        config.pixel_dither = json["pixel"]["dither"];
+        config.pixel_spi_clock = json["pixel"]["spiClock"];
+        config.pixel_spi_bright = json["pixel"]["spiBright"];
+
+        // Dual output settings aren't part of the web UI, keep them if missing
+        JsonObject& pixelJson = json["pixel"];
+        if (pixelJson.containsKey("split"))
+            config.pixel_split = pixelJson["split"];
+        if (pixelJson.containsKey("color2"))
+            config.pixel_color2 = PixelColor(static_cast<uint8_t>(pixelJson["color2"]));
     }
 
 #elif defined(ESPS_MODE_SERIAL)
@@ -1121,6 +1421,7 @@ void serializeConfig(String &jsonString, bool pretty, bool creds) {
 
     _effects["mirror"] = config.effect_mirror;
     _effects["allleds"] = config.effect_allleds;
+    _effects["white"] = config.effect_white;
     _effects["reverse"] = config.effect_reverse;
     _effects["speed"] = config.effect_speed;
     _effects["brightness"] = config.effect_brightness;
@@ -1157,6 +1458,17 @@ void serializeConfig(String &jsonString, bool pretty, bool creds) {
     e131["channel_start"] = config.channel_start;
     e131["channel_count"] = config.channel_count;
     e131["multicast"] = config.multicast;
+    e131["merge"] = config.e131_merge;
+    e131["artnet"] = config.artnet;
+    e131["ddp"] = config.ddp;
+    JsonArray &patch = e131.createNestedArray("patch");
+    for (uint8_t i = 0; i < config.patch_count; i++) {
+        JsonArray &p = patch.createNestedArray();
+        p.add(config.patch[i].universe);
+        p.add(config.patch[i].channel);
+        p.add(config.patch[i].offset);
+        p.add(config.patch[i].length);
+    }
 
 #if defined(ESPS_MODE_PIXEL)
     // Pixel
@@ -1167,6 +1479,11 @@ void serializeConfig(String &jsonString, bool pretty, bool creds) {
     pixel["zigSize"] = config.zigSize;
     pixel["gammaVal"] = config.gammaVal;
     pixel["briteVal"] = config.briteVal;
+    pixel["dither"] = config.pixel_dither;
+    pixel["spiClock"] = config.pixel_spi_clock;
+    pixel["spiBright"] = config.pixel_spi_bright;
+    pixel["split"] = config.pixel_split;
+    pixel["color2"] = static_cast<uint8_t>(config.pixel_color2);
 
 #elif defined(ESPS_MODE_SERIAL)
     // Serial
@@ -1212,7 +1529,7 @@ void dsGammaConfig(JsonObject &json) {
         if (config.gammaVal <= 0) { config.gammaVal = 2.2; }
         if (config.briteVal <= 0) { config.briteVal = 1.0; }
 
-        updateGammaTable(config.gammaVal, config.briteVal);
+        updateGammaTable(config.gammaVal, config.briteVal, pixels.isDithering());
     }
 }
 #endif
@@ -1262,16 +1579,17 @@ void loop() {
     handleButtons();
 #endif
 
-    e131_packet_t packet;
-
     // Reboot handler
     if (reboot) {
 
         effects.clearAll();
 
 #if defined(ESPS_MODE_PIXEL)
-        while (!pixels.canRefresh()) {};
+        while (!pixels.canRefresh())
+            pixels.update();
         pixels.show();
+        while (!pixels.canRefresh())
+            pixels.update();
 #elif defined(ESPS_MODE_SERIAL)
         while (!serial.canRefresh()) {};
         serial.show();
@@ -1287,83 +1605,88 @@ void loop() {
 
     // Render output for current data source
     if ( (config.ds == DataSource::E131) || (config.ds == DataSource::IDLEWEB) ) {
-        // Parse a packet and update pixels
-        if (!e131.isEmpty()) {
+        // Drain the queue so a stalled loop doesn't leave a backlog to replay
+        if (!e131.isEmpty() || !artnet.isEmpty() || !ddp.isEmpty()) {
             idleTicker.attach(config.effect_idletimeout, idleTimeout);
             if (config.ds == DataSource::IDLEWEB) {
                 config.ds = DataSource::E131;
             }
 
-            e131.pull(&packet);
-            uint16_t universe = htons(packet.universe);
-            uint8_t *data = packet.property_values + 1;
-            //LOG_PORT.print(universe);
-            //LOG_PORT.println(packet.sequence_number);
-            if ((universe >= config.universe) && (universe <= uniLast)) {
-                // Universe offset and sequence tracking
-                uint8_t uniOffset = (universe - config.universe);
-                if (packet.sequence_number != seqTracker[uniOffset]++) {
-                    LOG_PORT.print(F("Sequence Error - expected: "));
-                    LOG_PORT.print(seqTracker[uniOffset] - 1);
-                    LOG_PORT.print(F(" actual: "));
-                    LOG_PORT.print(packet.sequence_number);
-                    LOG_PORT.print(F(" universe: "));
-                    LOG_PORT.println(universe);
-                    seqError[uniOffset]++;
-                    seqTracker[uniOffset] = packet.sequence_number + 1;
+            // Packets are mapped straight out of the receive slots
+            e131_packet_t *packet;
+            input.drain();
+            for (uint8_t i = 0; i < E131_BUFFERS && (packet = e131.borrow()); i++) {
+                pktStamp = e131.stamp();
+                if (E131Rx::isSync(packet)) {
+                    if (input.sync(ntohs(packet->sync_universe)))
+                        commitInput();
+                } else {
+                    ingestE131(*packet);
                 }
+                e131.release();
+            }
 
-                // Offset the channels if required
-                uint16_t offset = 0;
-                offset = config.channel_start - 1;
-
-                // Find start of data based off the Universe
-                int16_t dataStart = uniOffset * config.universe_limit - offset;
-
-                // Calculate how much data we need for this buffer
-                uint16_t dataStop = config.channel_count;
-                uint16_t channels = htons(packet.property_value_count) - 1;
-                if (config.universe_limit < channels)
-                    channels = config.universe_limit;
-                if ((dataStart + channels) < dataStop)
-                    dataStop = dataStart + channels;
-
-                // Set the data
-                uint16_t buffloc = 0;
-
-                // ignore data from start of first Universe before channel_start
-                if (dataStart < 0) {
-                    dataStart = 0;
-                    buffloc = config.channel_start - 1;
+            artnet_packet_t *artPacket;
+            for (uint8_t i = 0; i < ARTNET_BUFFERS && (artPacket = artnet.borrow()); i++) {
+                pktStamp = micros();
+                if (ArtNetRx::isSync(artPacket)) {
+                    if (input.sync(ARTNET_SYNC_ADDR))
+                        commitInput();
+                } else {
+                    ingestArtNet(*artPacket);
                 }
+                artnet.release();
+            }
 
-                for (int i = dataStart; i < dataStop; i++) {
-#if defined(ESPS_MODE_PIXEL)
-                    pixels.setValue(i, data[buffloc]);
-#elif defined(ESPS_MODE_SERIAL)
-                    serial.setValue(i, data[buffloc]);
-#endif
-                    buffloc++;
-                }
+            ddp_packet_t *ddpPacket;
+            for (uint8_t i = 0; i < DDP_BUFFERS && (ddpPacket = ddp.borrow()); i++) {
+                pktStamp = micros();
+                // A newer whole frame is queued behind this one, skip ahead to it
+                if (ddp.pushQueued() > 1)
+                    input.stats.superseded++;
+                else
+                    ingestDDP(*ddpPacket);
+                ddp.release();
             }
         }
+
+        // Time out partial frames, there's no packet to time those from
+        pktStamp = 0;
+        if (input.poll())
+            commitInput();
     }
 
     if ( (config.ds == DataSource::WEB)
       || (config.ds == DataSource::IDLEWEB)
-      || (config.ds == DataSource::MQTT) ) {
+      || (config.ds == DataSource::MQTT)
+      || effects.hasLayers() ) {
             effects.run();
     }
 
     handleToggleGpio();
 
-/* Streaming refresh */
+/* Streaming refresh - skip unchanged frames, but keep-alive every E131_TIMEOUT */
 #if defined(ESPS_MODE_PIXEL)
-    if (pixels.canRefresh())
-        pixels.show();
+    pixels.update();
+    if (pixels.canRefresh()) {
+        if (pixels.isDirty() || (millis() - lastUpdate) >= E131_TIMEOUT) {
+            pixels.show();
+            uniStats.shown();
+            lastUpdate = millis();
+        } else {
+            pixels.skip();
+        }
+    }
 #elif defined(ESPS_MODE_SERIAL)
-    if (serial.canRefresh())
-        serial.show();
+    if (serial.canRefresh()) {
+        if (serial.isDirty() || (millis() - lastUpdate) >= E131_TIMEOUT) {
+            serial.show();
+            uniStats.shown();
+            lastUpdate = millis();
+        } else {
+            serial.skip();
+        }
+    }
 #endif
 
 /* Update the PWM outputs */
@@ -18,9 +18,13 @@ const EffectDesc EFFECT_LIST[] = {
     { "Chase",        &EffectEngine::effectChase,      "t_chase",        1,    1,    1,    0,  "T4"     },
     { "Fire flicker", &EffectEngine::effectFireFlicker,"t_fireflicker",  1,    0,    0,    0,  "T6"     },
     { "Lightning",    &EffectEngine::effectLightning,  "t_lightning",    1,    0,    0,    0,  "T7"     },
-    { "Breathe",      &EffectEngine::effectBreathe,    "t_breathe",      1,    0,    0,    0,  "T8"     }
+    { "Breathe",      &EffectEngine::effectBreathe,    "t_breathe",      1,    0,    0,    0,  "T8"     },
+    { "Program",      &EffectEngine::effectProgram,    "t_program",      1,    1,    1,    0,  "T9"     }
 };
 
+// Blend mode names, in BlendMode order
+static const char* BLEND_NAMES[] = { "normal", "add", "max", "multiply" };
+
 // Effect defaults
 #define DEFAULT_EFFECT_NAME "Disabled"
 #define DEFAULT_EFFECT_COLOR { 183, 0, 255 }
@@ -28,6 +32,7 @@ const EffectDesc EFFECT_LIST[] = {
 #define DEFAULT_EFFECT_REVERSE false
 #define DEFAULT_EFFECT_MIRROR false
 #define DEFAULT_EFFECT_ALLLEDS false
+#define DEFAULT_EFFECT_WHITE false
 #define DEFAULT_EFFECT_SPEED 6
 
 EffectEngine::EffectEngine() {
@@ -42,6 +47,7 @@ void EffectEngine::setFromDefaults() {
     config.effect_reverse = DEFAULT_EFFECT_REVERSE;
     config.effect_mirror = DEFAULT_EFFECT_MIRROR;
     config.effect_allleds = DEFAULT_EFFECT_ALLLEDS;
+    config.effect_white = DEFAULT_EFFECT_WHITE;
     config.effect_speed = DEFAULT_EFFECT_SPEED;
     setFromConfig();
 }
@@ -53,6 +59,7 @@ void EffectEngine::setFromConfig() {
     setReverse(config.effect_reverse);
     setMirror(config.effect_mirror);
     setAllLeds(config.effect_allleds);
+    setWhite(config.effect_white);
     setSpeed(config.effect_speed);
 }
 
@@ -62,6 +69,10 @@ void EffectEngine::setBrightness(float brightness) {
         _effectBrightness = 1.0;
     if (_effectBrightness < 0.0)
         _effectBrightness = 0.0;
+
+    // Scale once here rather than per channel on every frame
+    for (uint16_t i = 0; i < 256; i++)
+        _brightnessLut[i] = i * _effectBrightness;
 }
 
 // Yukky maths here. Input speeds from 1..10 get mapped to 17782..100
@@ -76,34 +87,213 @@ void EffectEngine::setDelay(uint16_t delay) {
         _effectDelay = MIN_EFFECT_DELAY;
 }
 
-void EffectEngine::begin(DRIVER* ledDriver, uint16_t ledCount) {
+void EffectEngine::begin(DRIVER* ledDriver, uint16_t ledCount, uint8_t ledChannels) {
     _ledDriver = ledDriver;
     _ledCount = ledCount;
+    _ledChannels = ledChannels;
+
+    if (_frame) free(_frame);
+    _frame = static_cast<CRGB *>(malloc(_ledCount * sizeof(CRGB)));
+    if (!_frame) {
+        LOG_PORT.println(F("*** EffectEngine: no memory for frame ***"));
+        _ledCount = 0;
+    } else {
+        memset(_frame, 0, _ledCount * sizeof(CRGB));
+    }
+
+    // Layer frames are sized to the old led count
+    _length = 0;
+    for (uint8_t i = 0; i < EFFECT_LAYERS; i++)
+        clearLayer(i);
+
     _initialized = true;
     _forwarder.begin(9374);
 }
 
+/*
+* Effects run on a fixed timestep: each step is scheduled from the one
+* before rather than from when it actually ran, so a long show() delays
+* steps without losing them. Up to EFFECT_CATCHUP late steps run back to
+* back, anything later than that is dropped and the schedule restarts.
+* It also restarts when the effect comes back after E1.31 or setEffect().
+* The frame goes out once the output can take it.
+*/
 void EffectEngine::run() {
-    if (_initialized && _activeEffect && _activeEffect->func) {
-        if (millis() - _effectLastRun >= _effectWait) {
-            _effectLastRun = millis();
-            uint16_t wait = (this->*_activeEffect->func)();
-            _effectWait = max((int)wait, MIN_EFFECT_DELAY);
-            _effectCounter++;
+    if (!_initialized)
+        return;
+
+    timeType now = _clock();
+
+    // The running effect is the base unless E1.31 is
+    bool running = config.ds != DataSource::E131 && _activeEffect && _activeEffect->func;
+    if (running) {
+        // Back from E1.31, start the schedule over rather than catch up
+        if (!_effectRunning)
+            _effectNext = now;
+        _length = _ledCount;
+        if (_effectMirror && _activeEffect->hasMirror)
+            _length = _length / 2;
+        if (_length && stepEffect(_activeEffect, _effectNext, now, _renderTime,
+                _effectCounter, _effectDropped))
+            _dirty = true;
+    }
+    _effectRunning = running;
+
+    for (uint8_t i = 0; i < EFFECT_LAYERS; i++) {
+        if (_layers[i].effect && runLayer(_layers[i], now))
+            _dirty = true;
+    }
+
+    if (_dirty && _ledDriver->canRefresh()) {
+        renderFrame();
+        _dirty = false;
+    }
+}
+
+/*
+* Run the steps of effect due by now, returns how many ran. The timing and
+* counts go to whoever runs it, the main effect or a layer.
+*/
+uint8_t EffectEngine::stepEffect(const EffectDesc* effect, timeType &next, timeType now,
+        uint32_t &renderTime, uint32_t &counter, uint32_t &dropped) {
+    uint8_t steps = 0;
+    while (static_cast<int32_t>(now - next) >= 0) {
+        if (steps == EFFECT_CATCHUP) {
+            next = now;
+            dropped++;
+            break;
         }
+        _effectTime = next;
+        uint32_t start = micros();
+        uint16_t wait = (this->*effect->func)();
+        renderTime = micros() - start;
+        next += max((int)wait, MIN_EFFECT_DELAY);
+        counter++;
+        steps++;
+    }
+    return steps;
+}
+
+/*
+* Run a layer's effect if it's due. Effects draw through the engine state,
+* so the layer's frame, step, color and flash count are swapped in around
+* the call.
+*/
+bool EffectEngine::runLayer(EffectLayer &layer, timeType now) {
+    if (static_cast<int32_t>(now - layer.next) < 0)
+        return false;
+
+    std::swap(_frame, layer.frame);
+    std::swap(_effectStep, layer.step);
+    std::swap(_effectColor, layer.color);
+    std::swap(_effectFlashes, layer.flashes);
+    uint16_t length = _length;
+    _length = _ledCount;
+
+    bool ran = stepEffect(layer.effect, layer.next, now, layer.renderTime,
+            layer.counter, layer.dropped);
+
+    _length = length;
+    std::swap(_effectFlashes, layer.flashes);
+    std::swap(_effectColor, layer.color);
+    std::swap(_effectStep, layer.step);
+    std::swap(_frame, layer.frame);
+    return ran;
+}
+
+bool EffectEngine::setLayer(uint8_t idx, const String effectName, CRGB color,
+        uint8_t opacity, BlendMode blend) {
+    if (idx >= EFFECT_LAYERS)
+        return false;
+
+    const EffectDesc* effect = nullptr;
+    const uint8_t effectCount = sizeof(EFFECT_LIST) / sizeof(EffectDesc);
+    for (uint8_t i = 0; i < effectCount; i++) {
+        if (effectName.equalsIgnoreCase(EFFECT_LIST[i].name))
+            effect = &EFFECT_LIST[i];
+    }
+    if (!effect || !effect->func || !_ledCount) {
+        clearLayer(idx);
+        return false;
+    }
+
+    EffectLayer &layer = _layers[idx];
+    if (!layer.frame) {
+        layer.frame = static_cast<CRGB *>(calloc(_ledCount, sizeof(CRGB)));
+        if (!layer.frame) {
+            LOG_PORT.println(F("*** EffectEngine: no memory for layer ***"));
+            return false;
+        }
+        _layerCount++;
+    }
+    if (layer.effect != effect) {
+        layer.effect = effect;
+        layer.step = 0;
+        layer.flashes = 0;
+        layer.next = _clock();
+        layer.renderTime = 0;
+        layer.counter = 0;
+        layer.dropped = 0;
+    }
+    layer.color = color;
+    layer.opacity = opacity;
+    layer.blend = blend;
+    return true;
+}
+
+void EffectEngine::clearLayer(uint8_t idx) {
+    if (idx >= EFFECT_LAYERS || !_layers[idx].frame)
+        return;
+
+    free(_layers[idx].frame);
+    _layers[idx] = {};
+    _layerCount--;
+
+    if (!_layerCount) {
+        // Put the plain base back, the last E1.31 frame or the running effect
+        if (config.ds == DataSource::E131 && _base)
+            _ledDriver->setData(_base, _baseSize);
+        else
+            renderFrame();
+        free(_base);
+        _base = nullptr;
+        _baseSize = 0;
     }
 }
 
+void EffectEngine::setBase(const uint8_t *data, uint16_t length) {
+    if (_baseSize != length) {
+        free(_base);
+        _base = static_cast<uint8_t *>(malloc(length));
+        _baseSize = _base ? length : 0;
+    }
+    if (_base)
+        memcpy(_base, data, length);
+
+    // Channels past the leds still go straight out
+    _ledDriver->setData(data, length);
+    renderFrame();
+}
+
+BlendMode EffectEngine::getBlendMode(const String name) {
+    for (uint8_t i = 0; i < sizeof(BLEND_NAMES) / sizeof(BLEND_NAMES[0]); i++) {
+        if (name.equalsIgnoreCase(BLEND_NAMES[i]))
+            return static_cast<BlendMode>(i);
+    }
+    return BlendMode::NORMAL;
+}
+
 void EffectEngine::setEffect(const String effectName) {
     const uint8_t effectCount = sizeof(EFFECT_LIST) / sizeof(EffectDesc);
     for (uint8_t effect = 0; effect < effectCount; effect++) {
         if ( effectName.equalsIgnoreCase(EFFECT_LIST[effect].name) ) {
+            // Set again after a pause the effect carries on from now
+            _effectNext = _clock();
             if (_activeEffect != &EFFECT_LIST[effect]) {
                 _activeEffect = &EFFECT_LIST[effect];
-                _effectLastRun = millis();
-                _effectWait = MIN_EFFECT_DELAY;
                 _effectCounter = 0;
                 _effectStep = 0;
+                _effectFlashes = 0;
             }
             return;
         }
@@ -147,29 +337,126 @@ bool EffectEngine::isValidEffect(const String effectName) {
 }
 
 void EffectEngine::setPixel(uint16_t idx,  CRGB color) {
-    _ledDriver->setValue(3 * idx + 0, (uint8_t)(color.r * _effectBrightness) );
-    _ledDriver->setValue(3 * idx + 1, (uint8_t)(color.g * _effectBrightness) );
-    _ledDriver->setValue(3 * idx + 2, (uint8_t)(color.b * _effectBrightness) );
+    if (idx < _length)
+        _frame[idx] = color;
 }
 
 void EffectEngine::setRange(uint16_t first, uint16_t len, CRGB color) {
-    for (uint16_t i=first; i < min(uint16_t(first+len), _ledCount); i++) {
-        setPixel(i, color);
+    for (uint16_t i=first; i < min(uint16_t(first+len), _length); i++) {
+        _frame[i] = color;
     }
 }
 
-void EffectEngine::clearRange(uint16_t first, uint16_t len) {
-    for (uint16_t i=first; i < min(uint16_t(first+len), _ledCount); i++) {
-        setPixel(i, {0, 0, 0});
+void EffectEngine::setAll(CRGB color) {
+    setRange(0, _length, color);
+}
+
+void EffectEngine::clearAll() {
+    if (_frame)
+        memset(_frame, 0, _ledCount * sizeof(CRGB));
+    for (uint16_t i=0; i < _ledCount * _ledChannels; i++) {
+        _ledDriver->setValue(i, 0);
     }
 }
 
-void EffectEngine::setAll(CRGB color) {
-    setRange(0, _ledCount, color);
+/* Scaled by brightness, with the white split out for RGBW */
+void EffectEngine::toChannels(CRGB color, uint8_t *out) {
+    uint8_t r = _brightnessLut[color.r];
+    uint8_t g = _brightnessLut[color.g];
+    uint8_t b = _brightnessLut[color.b];
+
+    if (_ledChannels > 3) {
+        // Move the part common to r, g and b onto the white led
+        uint8_t w = 0;
+        if (_effectWhite) {
+            w = min(r, min(g, b));
+            r -= w;
+            g -= w;
+            b -= w;
+        }
+        out[3] = w;
+    }
+
+    out[0] = r;
+    out[1] = g;
+    out[2] = b;
 }
 
-void EffectEngine::clearAll() {
-    clearRange(0, _ledCount);
+/* The logical frame pixel shown on led, mirroring grows out from the center */
+CRGB EffectEngine::basePixel(uint16_t led, bool reverse, bool mirror) {
+    uint16_t i = led;
+    if (mirror) {
+        if (led >= 2 * _length)
+            return {0, 0, 0};
+        i = led >= _length ? led - _length : _length - 1 - led;
+    } else if (led >= _length) {
+        return {0, 0, 0};
+    }
+    if (reverse)
+        i = _length - 1 - i;
+    return _frame[i];
+}
+
+/*
+* One pass over the leds. Reverse and mirror only apply to effects that
+* offer them. Layers blend per channel, so the white channel of an RGBW
+* base blends against the layer's split out white.
+*/
+void EffectEngine::renderFrame() {
+    uint32_t start = micros();
+    bool input = config.ds == DataSource::E131;
+    bool effect = !input && _activeEffect && _activeEffect->func;
+    bool reverse = effect && _effectReverse && _activeEffect->hasReverse;
+    bool mirror = effect && _effectMirror && _activeEffect->hasMirror;
+    uint8_t px[4];
+    uint8_t lp[4];
+
+    // Without layers E1.31 goes straight to the driver
+    if (input && !_layerCount)
+        return;
+
+    for (uint16_t led=0; led < _ledCount; led++) {
+        uint16_t base = _ledChannels * led;
+
+        if (input) {
+            for (uint8_t c=0; c < _ledChannels; c++)
+                px[c] = base + c < _baseSize ? _base[base + c] : 0;
+        } else if (effect) {
+            toChannels(basePixel(led, reverse, mirror), px);
+        } else {
+            memset(px, 0, sizeof(px));
+        }
+
+        for (uint8_t l=0; l < EFFECT_LAYERS; l++) {
+            const EffectLayer &layer = _layers[l];
+            if (!layer.effect)
+                continue;
+            toChannels(layer.frame[led], lp);
+            for (uint8_t c=0; c < _ledChannels; c++) {
+                uint8_t v;
+                switch (layer.blend) {
+                    case BlendMode::ADD:
+                        v = min(px[c] + lp[c], 255);
+                        break;
+                    case BlendMode::MAX:
+                        v = max(px[c], lp[c]);
+                        break;
+                    case BlendMode::MULTIPLY:
+                        v = scale8(px[c], lp[c]);
+                        break;
+                    default:
+                        v = lp[c];
+                        break;
+                }
+                px[c] = blend8(px[c], v, layer.opacity);
+            }
+        }
+
+        for (uint8_t c=0; c < _ledChannels; c++)
+            _ledDriver->setValue(base + c, px[c]);
+    }
+
+    _composeTime = micros() - start;
 }
 
 CRGB EffectEngine::colorWheel(uint8_t pos) {
@@ -186,78 +473,34 @@ CRGB EffectEngine::colorWheel(uint8_t pos) {
 }
 
 uint16_t EffectEngine::effectSolidColor() {
-    for (uint16_t i=0; i < _ledCount; i++) {
-        setPixel(i, _effectColor);
-    }
+    setAll(_effectColor);
     return 32;
 }
 
 uint16_t EffectEngine::effectChase() {
-    // calculate only half the pixels if mirroring
-    uint16_t lc = _ledCount;
-    if (_effectMirror) {
-        lc = lc / 2;
-    }
     // Prevent errors if we come from another effect with more steps
     // or switch from the upper half of non-mirror to mirror mode
-    _effectStep = _effectStep % lc;
-
-    for (uint16_t i=0; i < lc; i++) {
-        if (i != _effectStep) {
-            if (_effectMirror) {
-                setPixel(i + lc, {0, 0, 0});
-                setPixel(lc - 1 - i, {0, 0, 0});
-            } else {
-                setPixel(i, {0, 0, 0});
-            }
-        }
-    }
-    uint16_t pixel = _effectStep;
-    if (_effectReverse) {
-      pixel = lc - 1 - pixel;
-    }
-    if (_effectMirror) {
-        setPixel(pixel + lc, _effectColor);
-        setPixel(lc - 1 - pixel, _effectColor);
-    } else {
-        setPixel(pixel, _effectColor);
-    }
+    _effectStep = _effectStep % _length;
+
+    setAll({0, 0, 0});
+    setPixel(_effectStep, _effectColor);
 
-    _effectStep = (1+_effectStep) % lc;
+    _effectStep = (1+_effectStep) % _length;
     return _effectDelay / 32;
 }
 
 uint16_t EffectEngine::effectRainbow() {
-    // calculate only half the pixels if mirroring
-    uint16_t lc = _ledCount;
-    if (_effectMirror) {
-        lc = lc / 2;
-    }
-    for (uint16_t i=0; i < lc; i++) {
-//      CRGB color = colorWheel(((i * 256 / lc) + _effectStep) & 0xFF);
+    // saturation and value come from the effect color, only the hue turns
+    CHSV hsv = rgb2hsv(_effectColor);
+    for (uint16_t i=0; i < _length; i++) {
+//      CRGB color = colorWheel(((i * 256 / _length) + _effectStep) & 0xFF);
 
-        double hue = 0;
         if (_effectAllLeds) {
-            hue = _effectStep*360.0d / 256;	// all same colour
-        } else {
-            hue = 360.0 * (((i * 256 / lc) + _effectStep) & 0xFF) / 255;
-        }
-// dCHSV hue 0->360 sat 0->1.0 val 0->1.0
-        dCHSV my_hsv = rgb2hsv(_effectColor);
-        double sat = my_hsv.s;
-        double val = my_hsv.v;
-        CRGB color = hsv2rgb ( { hue, sat, val } );
-
-        uint16_t pixel = i;
-        if (_effectReverse) {
-            pixel = lc - 1 - pixel;
-        }
-        if (_effectMirror) {
-            setPixel(pixel + lc, color);
-            setPixel(lc - 1 - pixel, color);
+            hsv.h = _effectStep << 8;	// all same colour
         } else {
-            setPixel(pixel, color);
+            hsv.h = (((i * 256 / _length) + _effectStep) & 0xFF) << 8;
         }
+        setPixel(i, hsv2rgb(hsv));
     }
 
     _effectStep = (1+_effectStep) & 0xFF;
@@ -268,7 +511,7 @@ uint16_t EffectEngine::effectBlink() {
     // The Blink effect uses two "time slots": on, off
     // Using default delay, a complete sequence takes 2s.
     if (_effectStep % 2) {
-      clearAll();
+      setAll({0, 0, 0});
     } else {
       setAll(_effectColor);
     }
@@ -289,7 +532,7 @@ uint16_t EffectEngine::effectFlash() {
         setAll(_effectColor);
         break;
       default:
-        clearAll();
+        setAll({0, 0, 0});
     }
 
     _effectStep = (1+_effectStep) % 6;
@@ -299,25 +542,23 @@ uint16_t EffectEngine::effectFlash() {
 uint16_t EffectEngine::effectFireFlicker() {
   byte rev_intensity = 6; // more=less intensive, less=more intensive
   byte lum = max(_effectColor.r, max(_effectColor.g, _effectColor.b)) / rev_intensity;
-  for ( int i = 0; i < _ledCount; i++) {
+  for ( int i = 0; i < _length; i++) {
     byte flicker = random(lum);
     setPixel(i, CRGB { max(_effectColor.r - flicker, 0), max(_effectColor.g - flicker, 0), max(_effectColor.b - flicker, 0) });
   }
-  _effectStep = (1+_effectStep) % _ledCount;
+  _effectStep = (1+_effectStep) % _length;
   return _effectDelay / 10;
 }
 
 uint16_t EffectEngine::effectLightning() {
-  static byte maxFlashes;
-  static int timeslot = _effectDelay / 1000; // 1ms
   int flashPause = 10; // 10ms
-  uint16_t ledStart = random(_ledCount);
-  uint16_t ledLen = random(1, _ledCount - ledStart);
+  uint16_t ledStart = random(_length);
+  uint16_t ledLen = random(1, _length - ledStart);
   byte intensity; // flash intensity
 
   if (_effectStep % 2) {
     // odd steps = clear
-    clearAll();
+    setAll({0, 0, 0});
     if (_effectStep == 1) {
       // pause after 1st flash is longer
       flashPause = 130;
@@ -328,7 +569,7 @@ uint16_t EffectEngine::effectLightning() {
     // even steps = flashes
     if (_effectStep == 0) {
       // first flash (weaker and longer pause)
-      maxFlashes = random(3, 8); // 2-6 follow-up flashes
+      _effectFlashes = random(3, 8); // 2-6 follow-up flashes
       intensity = random(128);
     } else {
       // follow-up flashes (stronger)
@@ -341,11 +582,12 @@ uint16_t EffectEngine::effectLightning() {
 
   _effectStep++;
 
-  if (_effectStep >= maxFlashes * 2) {
+  if (_effectStep >= _effectFlashes * 2) {
     _effectStep = 0;
     flashPause = random(100, 5001); // between 0.1 and 5s
   }
-  return timeslot * flashPause;
+  // Pauses are in ms at the default speed, scaled with it
+  return min(static_cast<uint32_t>(flashPause) * _effectDelay / 1000, static_cast<uint32_t>(MAX_EFFECT_DELAY));
 }
 
 uint16_t EffectEngine::effectBreathe() {
@@ -370,11 +612,31 @@ uint16_t EffectEngine::effectBreathe() {
    * for a nice explanation of the math.
    */
   // sin() is in radians, so 2*PI rad is a full period; compiler should optimize.
-  float val = (exp(sin(millis()/(_effectDelay*5.0)*2*PI)) - 0.367879441) * 0.106364766 + 0.75;
+  float val = (exp(sin(_effectTime/(_effectDelay*5.0)*2*PI)) - 0.367879441) * 0.106364766 + 0.75;
   setAll({_effectColor.r*val, _effectColor.g*val, _effectColor.b*val});
   return _effectDelay / 40; // update every 25ms
 }
 
+uint16_t EffectEngine::effectProgram() {
+    if (!_program.size()) {
+        setAll({0, 0, 0});
+        return 100;
+    }
+    _program.render(_frame, _length, _effectTime, _effectStep, _effectColor);
+    _effectStep++;
+    return _effectDelay / 40; // 25ms at the default speed
+}
+
+bool EffectEngine::setProgram(const char *source, String &error) {
+    if (!_program.compile(source, error))
+        return false;
+    if (!_program.save(source)) {
+        error = F("Program compiled but could not be saved");
+        return false;
+    }
+    return true;
+}
+
 void EffectEngine::sendUDPData() {
     if ( (config.effect_sendprotocol == 1) && (config.effect_sendIP) ) {
         if ( (config.ds == DataSource::WEB) || (config.ds == DataSource::MQTT) ) {
@@ -388,115 +650,6 @@ void EffectEngine::sendUDPData() {
     }
 }
 
-// dCHSV hue 0->360 sat 0->1.0 val 0->1.0
-dCHSV EffectEngine::rgb2hsv(CRGB in_int)
-{
-    dCHSV       out;
-    dCRGB       in = {in_int.r/255.0d, in_int.g/255.0d, in_int.b/255.0d};
-    double      min, max, delta;
-
-    min = in.r < in.g ? in.r : in.g;
-    min = min  < in.b ? min  : in.b;
-
-    max = in.r > in.g ? in.r : in.g;
-    max = max  > in.b ? max  : in.b;
-
-    out.v = max;                                // v
-    delta = max - min;
-    if (delta < 0.00001)
-    {
-        out.s = 0;
-        out.h = 0; // undefined, maybe nan?
-        return out;
-    }
-    if( max > 0.0 ) { // NOTE: if Max is == 0, this divide would cause a crash
-        out.s = (delta / max);                  // s
-    } else {
-        // if max is 0, then r = g = b = 0
-        // s = 0, v is undefined
-        out.s = 0.0;
-        out.h = NAN;                            // its now undefined
-        return out;
-    }
-    if( in.r >= max )                           // > is bogus, just keeps compilor happy
-        out.h = ( in.g - in.b ) / delta;        // between yellow & magenta
-    else
-    if( in.g >= max )
-        out.h = 2.0 + ( in.b - in.r ) / delta;  // between cyan & yellow
-    else
-        out.h = 4.0 + ( in.r - in.g ) / delta;  // between magenta & cyan
-
-    out.h *= 60.0;                              // degrees
-
-    if( out.h < 0.0 )
-        out.h += 360.0;
-
-    return out;
-}
-
-
-// dCHSV hue 0->360 sat 0->1.0 val 0->1.0
-CRGB EffectEngine::hsv2rgb(dCHSV in)
-{
-    double      hh, p, q, t, ff;
-    long        i;
-    dCRGB       out;
-    CRGB out_int = {0,0,0};
-
-    if(in.s <= 0.0) {       // < is bogus, just shuts up warnings
-        out.r = in.v;
-        out.g = in.v;
-        out.b = in.v;
-        out_int = {255*out.r, 255*out.g, 255*out.b};
-        return out_int;
-    }
-    hh = in.h;
-    if(hh >= 360.0) hh = 0.0;
-    hh /= 60.0;
-    i = (long)hh;
-    ff = hh - i;
-    p = in.v * (1.0 - in.s);
-    q = in.v * (1.0 - (in.s * ff));
-    t = in.v * (1.0 - (in.s * (1.0 - ff)));
-
-    switch(i) {
-    case 0:
-        out.r = in.v;
-        out.g = t;
-        out.b = p;
-        break;
-    case 1:
-        out.r = q;
-        out.g = in.v;
-        out.b = p;
-        break;
-    case 2:
-        out.r = p;
-        out.g = in.v;
-        out.b = t;
-        break;
-
-    case 3:
-        out.r = p;
-        out.g = q;
-        out.b = in.v;
-        break;
-    case 4:
-        out.r = t;
-        out.g = p;
-        out.b = in.v;
-        break;
-    case 5:
-    default:
-        out.r = in.v;
-        out.g = p;
-        out.b = q;
-        break;
-    }
-    out_int = {255*out.r, 255*out.g, 255*out.b};
-    return out_int;
-}
-
 // dump the current running effect options to the supplied json
 void EffectEngine::runningEffectToJson (JsonObject &json) {
     JsonObject &effect = json.createNestedObject("currentEffect");
@@ -513,6 +666,7 @@ void EffectEngine::runningEffectToJson (JsonObject &json) {
     effect["reverse"] = getReverse();
     effect["mirror"] = getMirror();
     effect["allleds"] = getAllLeds();
+    effect["white"] = getWhite();
     effect["startenabled"] = config.effect_startenabled;
     effect["idleenabled"] = config.effect_idleenabled;
     effect["idletimeout"] = config.effect_idletimeout;
@@ -523,6 +677,26 @@ void EffectEngine::runningEffectToJson (JsonObject &json) {
 }
 
 
+// dump the effect and layer render times to the supplied json
+void EffectEngine::layersToJson (JsonObject &json) {
+    JsonObject &stats = json.createNestedObject("effects");
+    stats["render_us"] = (String)_renderTime;
+    stats["compose_us"] = (String)_composeTime;
+    stats["dropped"] = (String)_effectDropped;
+    JsonArray &layers = stats.createNestedArray("layers");
+    for (uint8_t i = 0; i < EFFECT_LAYERS; i++) {
+        if (!_layers[i].effect)
+            continue;
+        JsonObject &layer = layers.createNestedObject();
+        layer["index"] = i;
+        layer["effect"] = _layers[i].effect->name;
+        layer["blend"] = BLEND_NAMES[static_cast<uint8_t>(_layers[i].blend)];
+        layer["opacity"] = _layers[i].opacity;
+        layer["render_us"] = (String)_layers[i].renderTime;
+        layer["dropped"] = (String)_layers[i].dropped;
+    }
+}
+
 // dump all the known effect and options to the supplied json
 void EffectEngine::EffectListToJson (JsonObject &json) {
     JsonObject &effectList = json.createNestedObject("effectList");
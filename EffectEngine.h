@@ -2,10 +2,14 @@
 #define EFFECTENGINE_H_
 
 #include <Ticker.h>
+#include "rgbhsv.h"
+#include "EffectVM.h"
 
 #define MIN_EFFECT_DELAY 10
 #define MAX_EFFECT_DELAY 65535
 #define DEFAULT_EFFECT_DELAY 1000
+#define EFFECT_LAYERS 2             /* Overlay layers composited over the base */
+#define EFFECT_CATCHUP 4            /* Late effect steps run back to back before dropping */
 
 #if defined(ESPS_MODE_PIXEL)
     #define DRIVER PixelDriver
@@ -14,27 +18,6 @@
 #endif
 
 class EffectEngine;
-// CRGB red, green, blue 0->255
-struct CRGB {
-    uint8_t r;
-    uint8_t g;
-    uint8_t b;
-};
-
-// dCRGB red, green, blue 0->1.0
-struct dCRGB {
-    double r;
-    double g;
-    double b;
-};
-
-// dCHSV hue 0->360 sat 0->1.0 val 0->1.0
-struct dCHSV {
-    double h;
-    double s;
-    double v;
-};
-
 /*
 * EffectFunc is the signiture used for all effects. Returns
 * the desired delay before the effect should trigger again
@@ -51,20 +34,55 @@ struct EffectDesc {
     String      wsTCode;
 };
 
+// How a layer combines with what is under it, before opacity
+enum class BlendMode : uint8_t {
+    NORMAL,
+    ADD,
+    MAX,
+    MULTIPLY
+};
+
+/*
+* An effect composited over the base, which is E1.31 input or the running
+* effect. Each layer keeps only what its effect last drew, the compositing
+* itself works a pixel at a time.
+*/
+struct EffectLayer {
+    const EffectDesc*   effect;         /* Layer effect, nullptr when unused */
+    CRGB*       frame;                  /* What the effect last drew, one entry per led */
+    CRGB        color;                  /* Layer effect color */
+    uint8_t     opacity;                /* 0 transparent to 255 opaque */
+    BlendMode   blend;                  /* Blend mode */
+    uint32_t    step;                   /* Layer effect step counter */
+    uint8_t     flashes;                /* Layer effect flash count, Lightning */
+    decltype(millis()) next;            /* When the layer effect steps next, engine clock */
+    uint32_t    renderTime;             /* How long the last layer effect step took, micros() */
+    uint32_t    counter;                /* Layer effect steps run */
+    uint32_t    dropped;                /* Times layer steps were dropped after falling behind */
+};
+
 class EffectEngine {
 
-private:
+public:
     using timeType = decltype(millis());
+    using ClockFunc = timeType (*)();
 
+private:
+    ClockFunc _clock                = millis;       /* Engine clock in ms, swappable for testing */
     const EffectDesc* _activeEffect = nullptr;      /* Pointer to the active effect descriptor */
-    uint32_t _effectWait            = 0;            /* How long to wait for the effect to run again */
-    timeType _effectLastRun         = 0;            /* When did the effect last run ? in millis() */
+    timeType _effectNext            = 0;            /* When the effect steps next, engine clock */
+    timeType _effectTime            = 0;            /* What time the running step stands for */
     uint32_t _effectCounter         = 0;            /* Counter for the number of calls to the active effect */
+    uint32_t _effectDropped         = 0;            /* Times steps were dropped after falling behind */
+    uint8_t _effectFlashes          = 0;            /* Flashes in this Lightning strike */
+    bool _effectRunning             = false;        /* Effect stepped on the last run() */
+    bool _dirty                     = false;        /* Effect output changed since last rendered */
     uint16_t _effectSpeed           = 6;            /* Externally controlled effect speed 1..10 */
     uint16_t _effectDelay           = 1000;         /* Internal representation of speed */
     bool _effectReverse             = false;        /* Externally controlled effect reverse option */
     bool _effectMirror              = false;        /* Externally controlled effect mirroring (start at center) */
     bool _effectAllLeds             = false;        /* Externally controlled effect all leds = 1st led */
+    bool _effectWhite               = false;        /* Drive the white channel from the common part of RGB */
     float _effectBrightness         = 1.0;          /* Externally controlled effect brightness [0, 255] */
     CRGB _effectColor               = {0,0,0};      /* Externally controlled effect color */
 
@@ -73,19 +91,35 @@ private:
     bool _initialized               = false;        /* Boolean indicating if the engine is initialzied */
     DRIVER* _ledDriver              = nullptr;      /* Pointer to the active LED driver */
     uint16_t _ledCount              = 0;            /* Number of RGB leds (not channels) */
+    uint8_t _ledChannels            = 3;            /* Channels per led, 4 for RGBW */
+
+    CRGB* _frame                    = nullptr;      /* Logical frame the effects render into */
+    uint16_t _length                = 0;            /* Logical frame length, half the leds when mirroring */
+    uint8_t _brightnessLut[256];                    /* Channel values scaled by _effectBrightness */
+
+    EffectLayer _layers[EFFECT_LAYERS] = {};        /* Overlays, bottom first */
+    uint8_t _layerCount             = 0;            /* Layers in use */
+    uint8_t* _base                  = nullptr;      /* Last E1.31 frame, kept while layers are in use */
+    uint16_t _baseSize              = 0;            /* Size of _base */
+    uint32_t _renderTime            = 0;            /* How long the last effect step took, micros() */
+    uint32_t _composeTime           = 0;            /* How long the last renderFrame() took, micros() */
+
+    EffectVM _program;                              /* Uploaded effect program */
 
     WiFiUDP _forwarder;
 
 public:
     EffectEngine();
 
-    void begin(DRIVER* ledDriver, uint16_t ledCount);
+    void begin(DRIVER* ledDriver, uint16_t ledCount, uint8_t ledChannels = 3);
     void run();
+    void setClock(ClockFunc clock)          { _clock = clock; }
 
     String getEffect()                      { return _activeEffect ? _activeEffect->name : ""; }
     bool getReverse()                       { return _effectReverse; }
     bool getMirror()                        { return _effectMirror; }
     bool getAllLeds()                       { return _effectAllLeds; }
+    bool getWhite()                         { return _effectWhite; }
     float getBrightness()                   { return _effectBrightness; }
     uint16_t getDelay()                     { return _effectDelay; }
     uint16_t getSpeed()                     { return _effectSpeed; }
@@ -99,17 +133,33 @@ public:
 
     void runningEffectToJson (JsonObject &json);
     void EffectListToJson (JsonObject &json );
+    void layersToJson (JsonObject &json);
 
     bool isValidEffect(const String effectName);
     void setEffect(const String effectName);
     void setReverse(bool reverse)           { _effectReverse = reverse; }
     void setMirror(bool mirror)             { _effectMirror = mirror; }
     void setAllLeds(bool allleds)           { _effectAllLeds = allleds; }
+    void setWhite(bool white)               { _effectWhite = white; }
     void setBrightness(float brightness);
     void setSpeed(uint16_t speed);
     void setDelay(uint16_t delay);
     void setColor(CRGB color)               { _effectColor = color; }
 
+    // Layers, composited over the base in index order
+    bool setLayer(uint8_t idx, const String effectName, CRGB color, uint8_t opacity, BlendMode blend);
+    void clearLayer(uint8_t idx);
+    bool hasLayers()                        { return _layerCount; }
+    static BlendMode getBlendMode(const String name);
+
+    /* Take a latched E1.31 frame as the base for the layers */
+    void setBase(const uint8_t *data, uint16_t length);
+
+    // Effect program, compiled and saved on upload
+    bool setProgram(const char *source, String &error);
+    void loadProgram()                      { _program.load(); }
+    uint16_t getProgramSize()               { return _program.size(); }
+
     // Effect functions
     uint16_t effectSolidColor();
     uint16_t effectRainbow();
@@ -119,6 +169,7 @@ public:
     uint16_t effectFireFlicker();
     uint16_t effectLightning();
     uint16_t effectBreathe();
+    uint16_t effectProgram();
     uint16_t effectNull();
     void clearAll();
 
@@ -126,14 +177,21 @@ public:
 
 private:
 
+    // Effects draw into the logical frame, [0, _length)
     void setPixel(uint16_t idx,  CRGB color);
     void setRange(uint16_t first, uint16_t len, CRGB color);
-    void clearRange(uint16_t first, uint16_t len);
     void setAll(CRGB color);
 
+    // Brightness, white, reverse and mirror from the logical frame to the driver,
+    // with the layers composited on top
+    void renderFrame();
+    CRGB basePixel(uint16_t led, bool reverse, bool mirror);
+    void toChannels(CRGB color, uint8_t *out);
+    uint8_t stepEffect(const EffectDesc* effect, timeType &next, timeType now, uint32_t &renderTime,
+            uint32_t &counter, uint32_t &dropped);
+    bool runLayer(EffectLayer &layer, timeType now);
+
     CRGB colorWheel(uint8_t pos);
-    dCHSV rgb2hsv(CRGB in);
-    CRGB hsv2rgb(dCHSV in);
 };
 
 #endif
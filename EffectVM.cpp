@@ -0,0 +1,438 @@
+/*
+* EffectVM.cpp - Compiled effect programs for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include <FS.h>
+#include "ESPixelStick.h"
+#include "EffectVM.h"
+
+/* Opcodes, one byte each. Literals follow their push opcode, little endian */
+enum vm_op_t : uint8_t {
+    OP_PUSH8, OP_PUSH16, OP_PUSH32,
+    OP_I, OP_N, OP_X, OP_T, OP_S, OP_R, OP_G, OP_B,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_NEG, OP_ABS, OP_MIN, OP_MAX,
+    OP_AND, OP_OR, OP_XOR, OP_SHL, OP_SHR,
+    OP_LT, OP_GT, OP_EQ, OP_SEL,
+    OP_DUP, OP_DROP, OP_SWAP, OP_OVER,
+    OP_SIN, OP_TRI, OP_NOISE, OP_RAND, OP_SCALE, OP_HSV,
+    OP_COUNT
+};
+
+/* Words and their stack effect */
+typedef struct {
+    const char  *word;
+    uint8_t     op;
+    uint8_t     pop;        // Values taken
+    uint8_t     push;       // Values left
+} vm_word_t;
+
+static const vm_word_t VM_WORDS[] = {
+    { "i",      OP_I,       0, 1 },
+    { "n",      OP_N,       0, 1 },
+    { "x",      OP_X,       0, 1 },
+    { "t",      OP_T,       0, 1 },
+    { "s",      OP_S,       0, 1 },
+    { "r",      OP_R,       0, 1 },
+    { "g",      OP_G,       0, 1 },
+    { "b",      OP_B,       0, 1 },
+    { "+",      OP_ADD,     2, 1 },
+    { "-",      OP_SUB,     2, 1 },
+    { "*",      OP_MUL,     2, 1 },
+    { "/",      OP_DIV,     2, 1 },
+    { "%",      OP_MOD,     2, 1 },
+    { "neg",    OP_NEG,     1, 1 },
+    { "abs",    OP_ABS,     1, 1 },
+    { "min",    OP_MIN,     2, 1 },
+    { "max",    OP_MAX,     2, 1 },
+    { "&",      OP_AND,     2, 1 },
+    { "|",      OP_OR,      2, 1 },
+    { "^",      OP_XOR,     2, 1 },
+    { "<<",     OP_SHL,     2, 1 },
+    { ">>",     OP_SHR,     2, 1 },
+    { "<",      OP_LT,      2, 1 },
+    { ">",      OP_GT,      2, 1 },
+    { "=",      OP_EQ,      2, 1 },
+    { "?",      OP_SEL,     3, 1 },
+    { "dup",    OP_DUP,     1, 2 },
+    { "drop",   OP_DROP,    1, 0 },
+    { "swap",   OP_SWAP,    2, 2 },
+    { "over",   OP_OVER,    2, 3 },
+    { "sin",    OP_SIN,     1, 1 },
+    { "tri",    OP_TRI,     1, 1 },
+    { "noise",  OP_NOISE,   1, 1 },
+    { "rand",   OP_RAND,    0, 1 },
+    { "scale",  OP_SCALE,   2, 1 },
+    { "hsv",    OP_HSV,     3, 3 }
+};
+
+#define VM_WORD_COUNT   (sizeof(VM_WORDS) / sizeof(vm_word_t))
+#define VM_WORD_LEN     11          /* Longest word, numbers included */
+#define VM_GUARD        3           /* Most stack slots one instruction reaches past sp */
+
+/* First quarter of a sine wave, 0 - 127 */
+static const uint8_t QUARTER_SINE[65] = {
+    0, 3, 6, 9, 12, 16, 19, 22, 25, 28, 31, 34, 37, 40, 43, 46,
+    49, 51, 54, 57, 60, 63, 65, 68, 71, 73, 76, 78, 81, 83, 85, 88,
+    90, 92, 94, 96, 98, 100, 102, 104, 106, 107, 109, 111, 112, 113, 115, 116,
+    117, 118, 120, 121, 122, 122, 123, 124, 125, 125, 126, 126, 126, 127, 127, 127,
+    127
+};
+
+static uint32_t rng = 1;    // xorshift state for rand
+
+/* Integer maths wraps like the CPU does, rather than being undefined */
+static inline int32_t wrap(uint32_t v) {
+    return static_cast<int32_t>(v);
+}
+
+static inline uint8_t clamp8(int32_t v) {
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+static inline int32_t sin8(int32_t phase) {
+    uint8_t k = phase & 63;
+    switch ((phase >> 6) & 3) {
+        case 0:  return 128 + QUARTER_SINE[k];
+        case 1:  return 128 + QUARTER_SINE[64 - k];
+        case 2:  return 128 - QUARTER_SINE[k];
+        default: return 128 - QUARTER_SINE[64 - k];
+    }
+}
+
+static inline int32_t tri8(int32_t phase) {
+    uint8_t p = phase;
+    return p < 128 ? p * 2 : 511 - p * 2;
+}
+
+/* Value noise, a random level every 256 with smoothstep in between */
+static inline uint8_t hash8(int32_t k) {
+    uint32_t h = static_cast<uint32_t>(k) * 2654435761u;
+    return (h ^ (h >> 15)) >> 24;
+}
+
+static inline int32_t noise8(int32_t phase) {
+    int32_t a = hash8(phase >> 8);
+    int32_t b = hash8((phase >> 8) + 1);
+    int32_t f = phase & 0xff;
+    f = (f * f * (768 - 2 * f)) >> 16;
+    return a + (((b - a) * f) >> 8);
+}
+
+bool EffectVM::compile(const char *source, String &error) {
+    uint8_t     out[VM_CODE_MAX];
+    uint16_t    len = 0;
+    uint8_t     depth = 0;
+    bool        pixel = false;
+    char        word[VM_WORD_LEN + 1];
+
+    if (strlen(source) > VM_SOURCE_MAX) {
+        error = F("Program is too long");
+        return false;
+    }
+
+    const char *p = source;
+    while (*p) {
+        // Skip blanks and comments
+        if (isspace(*p)) {
+            p++;
+            continue;
+        }
+        if (*p == '#') {
+            while (*p && *p != '\n')
+                p++;
+            continue;
+        }
+
+        uint8_t wlen = 0;
+        while (p[wlen] && !isspace(p[wlen]))
+            wlen++;
+        if (wlen > VM_WORD_LEN) {
+            error = String(F("Word too long: ")) + String(p).substring(0, wlen);
+            return false;
+        }
+        memcpy(word, p, wlen);
+        word[wlen] = 0;
+        p += wlen;
+
+        if (len + 5 > VM_CODE_MAX) {
+            error = F("Program compiles too large");
+            return false;
+        }
+
+        // Numbers
+        if (isdigit(word[0]) || (word[0] == '-' && isdigit(word[1]))) {
+            char *end;
+            int32_t v = strtol(word, &end, 10);
+            if (*end) {
+                error = String(F("Bad number: ")) + word;
+                return false;
+            }
+            if (v >= INT8_MIN && v <= INT8_MAX) {
+                out[len++] = OP_PUSH8;
+                out[len++] = v;
+            } else if (v >= INT16_MIN && v <= INT16_MAX) {
+                out[len++] = OP_PUSH16;
+                out[len++] = v;
+                out[len++] = v >> 8;
+            } else {
+                out[len++] = OP_PUSH32;
+                out[len++] = v;
+                out[len++] = v >> 8;
+                out[len++] = v >> 16;
+                out[len++] = v >> 24;
+            }
+            if (++depth > VM_STACK) {
+                error = String(F("Stack deeper than ")) + VM_STACK + F(" at ") + word;
+                return false;
+            }
+            continue;
+        }
+
+        const vm_word_t *w = nullptr;
+        for (uint8_t i = 0; i < VM_WORD_COUNT; i++) {
+            if (!strcmp(word, VM_WORDS[i].word)) {
+                w = &VM_WORDS[i];
+                break;
+            }
+        }
+        if (!w) {
+            error = String(F("Unknown word: ")) + word;
+            return false;
+        }
+        if (depth < w->pop) {
+            error = String(word) + F(" needs ") + w->pop + F(" values");
+            return false;
+        }
+        depth += w->push - w->pop;
+        if (depth > VM_STACK) {
+            error = String(F("Stack deeper than ")) + VM_STACK + F(" at ") + word;
+            return false;
+        }
+        if (w->op == OP_I || w->op == OP_X || w->op == OP_RAND)
+            pixel = true;
+        out[len++] = w->op;
+    }
+
+    if (depth != 3) {
+        error = String(F("Program leaves ")) + depth + F(" values, needs r g b");
+        return false;
+    }
+
+    memcpy(code, out, len);
+    codeSize = len;
+    perPixel = pixel;
+    return true;
+}
+
+bool EffectVM::save(const char *source) {
+    File file = SPIFFS.open(VM_SOURCE_FILE, "w");
+    if (!file)
+        return false;
+    file.print(source);
+    file.close();
+
+    file = SPIFFS.open(VM_CODE_FILE, "w");
+    if (!file)
+        return false;
+    uint8_t header[6] = { 'V', 'M', VM_VERSION, perPixel,
+            static_cast<uint8_t>(codeSize), static_cast<uint8_t>(codeSize >> 8) };
+    file.write(header, sizeof(header));
+    file.write(code, codeSize);
+    file.close();
+    return true;
+}
+
+/*
+* The stored program is checked again before it's trusted, run() relies on
+* every opcode being known and the stack staying in bounds.
+*/
+bool EffectVM::load() {
+    uint8_t header[6];
+    uint8_t buf[VM_CODE_MAX];
+
+    codeSize = 0;
+    File file = SPIFFS.open(VM_CODE_FILE, "r");
+    if (!file)
+        return false;
+    if (file.read(header, sizeof(header)) != sizeof(header) ||
+            header[0] != 'V' || header[1] != 'M' || header[2] != VM_VERSION) {
+        LOG_PORT.println(F("*** Effect program format error ***"));
+        return false;
+    }
+    uint16_t len = header[4] | header[5] << 8;
+    if (len > VM_CODE_MAX || file.read(buf, len) != len) {
+        LOG_PORT.println(F("*** Effect program truncated ***"));
+        return false;
+    }
+    file.close();
+
+    uint16_t pc = 0;
+    uint8_t depth = 0;
+    while (pc < len) {
+        uint8_t op = buf[pc++];
+        if (op <= OP_PUSH32) {
+            pc += op == OP_PUSH8 ? 1 : op == OP_PUSH16 ? 2 : 4;
+            depth++;
+        } else {
+            const vm_word_t *w = nullptr;
+            for (uint8_t i = 0; i < VM_WORD_COUNT; i++) {
+                if (VM_WORDS[i].op == op)
+                    w = &VM_WORDS[i];
+            }
+            if (!w || depth < w->pop)
+                break;
+            depth += w->push - w->pop;
+        }
+        if (depth > VM_STACK)
+            break;
+    }
+    if (pc != len || depth != 3) {
+        LOG_PORT.println(F("*** Effect program failed verification ***"));
+        return false;
+    }
+
+    memcpy(code, buf, len);
+    codeSize = len;
+    perPixel = header[3];
+    return true;
+}
+
+void EffectVM::render(CRGB *frame, uint16_t length, uint32_t t, uint32_t step, CRGB color) {
+    if (!length)
+        return;
+
+    if (!perPixel) {
+        CRGB c = run(0, length, 0, t, step, color);
+        for (uint16_t i = 0; i < length; i++)
+            frame[i] = c;
+        return;
+    }
+
+    // Position along the string in 16.16, saves a divide per pixel
+    uint32_t xstep = (256UL << 16) / length;
+    uint32_t x = 0;
+    for (uint16_t i = 0; i < length; i++) {
+        frame[i] = run(i, length, x >> 16, t, step, color);
+        x += xstep;
+    }
+}
+
+/*
+* Compile and load time checks keep the stack in bounds. Should the code
+* get past them anyway, VM_GUARD slots either side take the stray reads
+* and writes of one instruction and sp is pulled back after each one.
+*/
+CRGB EffectVM::run(int32_t i, int32_t n, int32_t x, int32_t t, int32_t s, CRGB color) {
+    int32_t stack[VM_GUARD + VM_STACK + VM_GUARD];
+    int32_t *const bottom = stack + VM_GUARD;
+    int32_t *const top = bottom + VM_STACK;
+    int32_t *sp = bottom;
+    const uint8_t *pc = code;
+    const uint8_t *end = code + codeSize;
+
+    bottom[-3] = bottom[-2] = bottom[-1] = 0;
+    while (pc < end) {
+        if (sp < bottom)
+            sp = bottom;
+        else if (sp > top)
+            sp = top;
+
+        switch (*pc++) {
+            case OP_PUSH8:
+                *sp++ = static_cast<int8_t>(pc[0]);
+                pc += 1;
+                break;
+            case OP_PUSH16:
+                *sp++ = static_cast<int16_t>(pc[0] | pc[1] << 8);
+                pc += 2;
+                break;
+            case OP_PUSH32:
+                *sp++ = static_cast<int32_t>(pc[0] | pc[1] << 8 | pc[2] << 16 |
+                        static_cast<uint32_t>(pc[3]) << 24);
+                pc += 4;
+                break;
+
+            case OP_I: *sp++ = i; break;
+            case OP_N: *sp++ = n; break;
+            case OP_X: *sp++ = x; break;
+            case OP_T: *sp++ = t; break;
+            case OP_S: *sp++ = s; break;
+            case OP_R: *sp++ = color.r; break;
+            case OP_G: *sp++ = color.g; break;
+            case OP_B: *sp++ = color.b; break;
+
+            case OP_ADD: sp--; sp[-1] = wrap(static_cast<uint32_t>(sp[-1]) + sp[0]); break;
+            case OP_SUB: sp--; sp[-1] = wrap(static_cast<uint32_t>(sp[-1]) - sp[0]); break;
+            case OP_MUL: sp--; sp[-1] = wrap(static_cast<uint32_t>(sp[-1]) * sp[0]); break;
+            case OP_DIV:
+                sp--;
+                sp[-1] = !sp[0] ? 0 : sp[0] == -1 ? wrap(0u - sp[-1]) : sp[-1] / sp[0];
+                break;
+            case OP_MOD:
+                sp--;
+                sp[-1] = (!sp[0] || sp[0] == -1) ? 0 : sp[-1] % sp[0];
+                break;
+            case OP_NEG: sp[-1] = wrap(0u - sp[-1]); break;
+            case OP_ABS: sp[-1] = sp[-1] < 0 ? wrap(0u - sp[-1]) : sp[-1]; break;
+            case OP_MIN: sp--; sp[-1] = sp[0] < sp[-1] ? sp[0] : sp[-1]; break;
+            case OP_MAX: sp--; sp[-1] = sp[0] > sp[-1] ? sp[0] : sp[-1]; break;
+
+            case OP_AND: sp--; sp[-1] &= sp[0]; break;
+            case OP_OR:  sp--; sp[-1] |= sp[0]; break;
+            case OP_XOR: sp--; sp[-1] ^= sp[0]; break;
+            case OP_SHL: sp--; sp[-1] = static_cast<uint32_t>(sp[-1]) << (sp[0] & 31); break;
+            case OP_SHR: sp--; sp[-1] >>= (sp[0] & 31); break;
+
+            case OP_LT: sp--; sp[-1] = sp[-1] < sp[0]; break;
+            case OP_GT: sp--; sp[-1] = sp[-1] > sp[0]; break;
+            case OP_EQ: sp--; sp[-1] = sp[-1] == sp[0]; break;
+            case OP_SEL: sp -= 2; sp[-1] = sp[-1] ? sp[0] : sp[1]; break;
+
+            case OP_DUP:  *sp = sp[-1]; sp++; break;
+            case OP_DROP: sp--; break;
+            case OP_SWAP: std::swap(sp[-1], sp[-2]); break;
+            case OP_OVER: *sp = sp[-2]; sp++; break;
+
+            case OP_SIN:   sp[-1] = sin8(sp[-1]); break;
+            case OP_TRI:   sp[-1] = tri8(sp[-1]); break;
+            case OP_NOISE: sp[-1] = noise8(sp[-1]); break;
+            case OP_RAND:
+                rng ^= rng << 13;
+                rng ^= rng >> 17;
+                rng ^= rng << 5;
+                *sp++ = rng & 0xff;
+                break;
+            case OP_SCALE: sp--; sp[-1] = wrap(static_cast<uint32_t>(sp[-1]) * sp[0]) / 255; break;
+            case OP_HSV: {
+                CRGB c = hsv2rgb({ static_cast<uint16_t>((sp[-3] & 0xff) << 8),
+                        clamp8(sp[-2]), clamp8(sp[-1]) });
+                sp[-3] = c.r;
+                sp[-2] = c.g;
+                sp[-1] = c.b;
+                break;
+            }
+        }
+    }
+
+    if (sp < bottom)
+        sp = bottom;
+    else if (sp > top)
+        sp = top;
+    return { clamp8(sp[-3]), clamp8(sp[-2]), clamp8(sp[-1]) };
+}
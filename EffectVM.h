@@ -0,0 +1,76 @@
+/*
+* EffectVM.h - Compiled effect programs for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef EFFECTVM_H_
+#define EFFECTVM_H_
+
+#include "rgbhsv.h"
+
+#define VM_SOURCE_MAX   1024            /* Program source size limit */
+#define VM_CODE_MAX     256             /* Bytecode size limit */
+#define VM_STACK        16              /* Stack depth, checked at compile time */
+#define VM_VERSION      1               /* Bytecode file layout */
+#define VM_SOURCE_FILE  "/effect.txt"   /* Program source, for editing */
+#define VM_CODE_FILE    "/effect.vm"    /* Compiled program */
+
+/*
+* Effect programs are whitespace separated words in postfix order, which
+* leave red, green and blue (clamped to 0-255) on the stack for each pixel.
+* Numbers are 32 bit integers, # starts a comment to the end of the line.
+*
+*   Inputs      i pixel index, n pixel count, x position 0-255 along the
+*               string, t time in ms, s frame count, r g b effect color
+*   Arithmetic  + - * / % neg abs min max & | ^ << >>, / and % by 0 give 0
+*   Logic       < > = give 1 or 0, "c a b ?" gives a if c isn't 0, else b
+*   Stack       dup drop swap over
+*   Built in    sin tri noise take a phase, 256 per cycle, and give 0-255
+*               rand gives 0-255, scale is a * b / 255
+*               hsv turns h s v, all 0-255, into r g b
+*
+* Programs that don't use i, x or rand run once per frame instead of once
+* per pixel. A rainbow:   x t 8 / + 255 255 hsv
+*/
+class EffectVM {
+ public:
+    /* Compile source, replacing the current program. On error the current program is kept */
+    bool compile(const char *source, String &error);
+
+    /* Save the current program and its source to SPIFFS */
+    bool save(const char *source);
+
+    /* Load the compiled program from SPIFFS */
+    bool load();
+
+    /* Render one frame of length pixels */
+    void render(CRGB *frame, uint16_t length, uint32_t t, uint32_t step, CRGB color);
+
+    /* Bytecode size, 0 for no program */
+    inline uint16_t size() {
+        return codeSize;
+    }
+
+ private:
+    uint8_t     code[VM_CODE_MAX];      // Bytecode
+    uint16_t    codeSize = 0;           // Bytecode size
+    bool        perPixel = false;       // Program depends on the pixel
+
+    CRGB run(int32_t i, int32_t n, int32_t x, int32_t t, int32_t s, CRGB color);
+};
+
+#endif /* EFFECTVM_H_ */
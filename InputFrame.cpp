@@ -0,0 +1,166 @@
+/*
+* InputFrame.cpp - E1.31 frame assembly for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include <algorithm>
+#include "InputFrame.h"
+
+bool InputFrame::begin(uint16_t size, uint8_t universes, uint8_t expected) {
+    bool retval = true;
+
+    if (data) free(data);
+    if (data = static_cast<uint8_t *>(malloc(size))) {
+        memset(data, 0, size);
+        this->size = size;
+    } else {
+        this->size = 0;
+        retval = false;
+    }
+
+    if (seen) free(seen);
+    if (batch) free(batch);
+    seen = static_cast<uint8_t *>(malloc((universes + 7) / 8));
+    batch = static_cast<uint8_t *>(malloc((universes + 7) / 8));
+    if (seen && batch) {
+        this->universes = universes;
+        this->expected = expected;
+        drain();
+    } else {
+        this->universes = 0;
+        retval = false;
+    }
+
+    lastSync = 0;
+    lastPush = 0;
+    reset();
+
+    return retval;
+}
+
+void InputFrame::reset() {
+    if (seen)
+        memset(seen, 0, (universes + 7) / 8);
+    count = 0;
+    ranges = false;
+    syncAddr = 0;
+}
+
+void InputFrame::drain() {
+    if (batch)
+        memset(batch, 0, (universes + 7) / 8);
+}
+
+bool InputFrame::start(uint8_t uni) {
+    if (uni >= universes)
+        return false;
+
+    const uint8_t mask = 1 << (uni % 8);
+    bool inBatch = batch[uni / 8] & mask;
+    batch[uni / 8] |= mask;
+
+    // Already have this one, the source has moved on to its next frame
+    if (seen[uni / 8] & mask) {
+        if (inBatch) {
+            // Queued behind a newer frame, it was never going to be shown
+            stats.superseded += count;
+            reset();
+            return false;
+        }
+
+        stats.frames_partial++;
+        reset();
+        return true;
+    }
+
+    return false;
+}
+
+bool InputFrame::received(uint8_t uni, uint16_t syncAddr) {
+    if (uni >= universes)
+        return false;
+
+    if (!count)
+        frameStart = millis();
+
+    seen[uni / 8] |= 1 << (uni % 8);
+    count++;
+    if (syncAddr)
+        this->syncAddr = syncAddr;
+
+    if (count == expected && !waitSync()) {
+        stats.frames_complete++;
+        reset();
+        return true;
+    }
+
+    return false;
+}
+
+bool InputFrame::sync(uint16_t syncAddr) {
+    stats.sync_packets++;
+    lastSync = millis();
+
+    if (count && syncAddr == this->syncAddr) {
+        stats.frames_synced++;
+        reset();
+        return true;
+    }
+
+    return false;
+}
+
+bool InputFrame::write(uint32_t offset, const uint8_t *data, uint16_t len, bool push) {
+    if (offset < size)
+        memcpy(this->data + offset, data, std::min(static_cast<uint32_t>(len), size - offset));
+
+    if (!count && !ranges)
+        frameStart = millis();
+    ranges = true;
+    if (push)
+        lastPush = millis();
+
+    if (push || (!pushActive() && offset + len >= size)) {
+        stats.frames_complete++;
+        reset();
+        return true;
+    }
+
+    return false;
+}
+
+bool InputFrame::poll() {
+    if (!count && !ranges)
+        return false;
+
+    // Complete frame whose sync source went away
+    if (!ranges && count == expected && !waitSync()) {
+        stats.frames_complete++;
+        reset();
+        return true;
+    }
+
+    // Sync sources may hold a frame as long as they like
+    if (!waitSync() && (millis() - frameStart) >= INPUT_FRAME_TIMEOUT) {
+        stats.frames_partial++;
+        reset();
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,111 @@
+/*
+* InputFrame.h - E1.31 frame assembly for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef INPUTFRAME_H_
+#define INPUTFRAME_H_
+
+#define INPUT_SYNC_TIMEOUT  2500    /* ms without sync packets before we stop waiting on them */
+#define INPUT_FRAME_TIMEOUT 100     /* ms a partial frame waits for its missing universes */
+#define INPUT_PUSH_TIMEOUT  2500    /* ms without PUSH before we latch on a full buffer instead */
+
+/* Input statistics */
+typedef struct {
+    uint32_t    frames_complete;    // Frames latched once every universe arrived
+    uint32_t    frames_partial;     // Frames latched with universes missing
+    uint32_t    frames_synced;      // Frames latched by a sync packet
+    uint32_t    sync_packets;       // Sync packets received
+    uint32_t    superseded;         // Queued packets dropped for a newer frame
+} input_stats_t;
+
+/*
+* Back buffer for incoming universes. Data is written here as packets
+* arrive and only handed to the output once a whole frame is in:
+*   - on a sync packet for our sync address, while a sync source is active
+*   - once every universe has arrived, when no sync source is active
+*   - when a universe repeats before the frame is complete, or the frame
+*     times out, with whatever made it
+* Within one drain of the receive queue a repeat means we fell behind, so the
+* older frame is dropped instead and only the newest one is kept.
+* Byte range input like DDP has no universes, a frame is latched on PUSH, or
+* once the end of the buffer is written while no sender is using PUSH, and
+* times out like a partial one otherwise.
+* Every call that returns true has latched a frame which must be committed
+* from getData() before any more data is written.
+*/
+class InputFrame {
+ public:
+    input_stats_t   stats;      // Statistics tracker
+
+    /* Frames span universes, expected of which carry data */
+    bool begin(uint16_t size, uint8_t universes, uint8_t expected);
+
+    /* Call before draining queued packets */
+    void drain();
+
+    /* Call before writing universe uni into the back buffer */
+    bool start(uint8_t uni);
+
+    /* Call once universe uni has been written, syncAddr 0 for none */
+    bool received(uint8_t uni, uint16_t syncAddr);
+
+    /* Call on every sync packet */
+    bool sync(uint16_t syncAddr);
+
+    /* Write len bytes at offset into the back buffer, push when the sender ends its frame */
+    bool write(uint32_t offset, const uint8_t *data, uint16_t len, bool push);
+
+    /* Call every loop to time out partial frames */
+    bool poll();
+
+    inline uint8_t* getData() {
+        return data;
+    }
+
+    inline uint16_t getSize() {
+        return size;
+    }
+
+ private:
+    uint8_t     *data;          // Back buffer
+    uint8_t     *seen;          // Universes received this frame, bitmap
+    uint8_t     *batch;         // Universes received this drain, bitmap
+    uint16_t    size;           // Size of back buffer
+    uint8_t     universes;      // Number of universes in the window
+    uint8_t     expected;       // Universes that make up a complete frame
+    uint8_t     count;          // Universes received this frame
+    bool        ranges;         // Byte ranges written this frame
+    uint16_t    syncAddr;       // Sync address of the frame being assembled
+    uint32_t    frameStart;     // When the first universe of this frame arrived
+    uint32_t    lastSync;       // When the last sync packet arrived
+    uint32_t    lastPush;       // When the last PUSH arrived
+
+    /* A sync source is active and this frame asked for it */
+    inline bool waitSync() {
+        return syncAddr && lastSync && (millis() - lastSync) < INPUT_SYNC_TIMEOUT;
+    }
+
+    /* A sender has used PUSH recently */
+    inline bool pushActive() {
+        return lastPush && (millis() - lastPush) < INPUT_PUSH_TIMEOUT;
+    }
+
+    void reset();
+};
+
+#endif /* INPUTFRAME_H_ */
@@ -33,4 +33,7 @@
 /* Enable support for udpraw packets on port 2801 */
 #define ESPS_ENABLE_UDPRAW
 
+/* Drive a second WS2811 string from UART0 (GPIO1/TX). Disables serial logging */
+//#define ESPS_ENABLE_DUAL_OUTPUT
+
 #endif  // MODE_H_
@@ -20,21 +20,27 @@
 #include <Arduino.h>
 #include <utility>
 #include <algorithm>
+#include <SPI.h>
+#include "Mode.h"
 #include "PixelDriver.h"
 
-extern "C" {
-#include <eagle_soc.h>
-#include <ets_sys.h>
-#include <uart.h>
-#include <uart_register.h>
-}
+static const uint8_t    *uart_buffer[2];        // Buffer tracker, per UART
+static const uint8_t    *uart_buffer_tail[2];   // Buffer tracker, per UART
+static bool             uart_midframe[2];       // FIFO has been filled at least once this frame
+static uint8_t          uart_pending;           // UARTs still sending this frame, bitmask
 
-static const uint8_t    *uart_buffer;       // Buffer tracker
-static const uint8_t    *uart_buffer_tail;  // Buffer tracker
+static const uint8_t    *gece_buffer;       // GECE pixel data being sent
+static uint8_t          *gece_packet;       // GECE packet buffer
+static uint8_t          gece_count;         // Number of GECE bulbs
+static uint8_t          gece_bulb;          // GECE bulb being sent
+static bool             gece_startbit;      // Next GECE timer event is a start bit
 
-uint8_t PixelDriver::rOffset = 0;
-uint8_t PixelDriver::gOffset = 1;
-uint8_t PixelDriver::bOffset = 2;
+pixel_stats_t PixelDriver::stats;
+uint8_t PixelDriver::stride = 3;
+uint8_t PixelDriver::offset[2][PIXEL_MAX_CHANNELS] = {
+    { 0, 1, 2, 3 },
+    { 0, 1, 2, 3 }
+};
 
 int PixelDriver::begin() {
     return begin(PixelType::WS2811, PixelColor::RGB, 170);
@@ -47,13 +53,19 @@ int PixelDriver::begin(PixelType type) {
 int PixelDriver::begin(PixelType type, PixelColor color, uint16_t length) {
     int retval = true;
 
+    // The buffers are about to go, the init for the new type sets the
+    // output up again and the next show() starts it
+    stop();
+
     this->type = type;
     this->color = color;
 
+    // Only WS2811 carries a white channel
+    stride = (type == PixelType::WS2811) ? pixelChannels(color) : 3;
     updateOrder(color);
 
     if (pixdata) free(pixdata);
-    szBuffer = length * 3;
+    szBuffer = length * stride;
     if (pixdata = static_cast<uint8_t *>(malloc(szBuffer))) {
         memset(pixdata, 0, szBuffer);
         numPixels = length;
@@ -63,41 +75,163 @@ int PixelDriver::begin(PixelType type, PixelColor color, uint16_t length) {
         retval = false;
     }
 
-    uint16_t szAsync = szBuffer;
-    if (type == PixelType::GECE) {
+    if (type == PixelType::GECE || type == PixelType::APA102) {
+        szPacket = (type == PixelType::GECE) ? GECE_PSIZE : APA102_SIZE(length);
+
+        // spiWrite() loads whole words, so pad to one and keep the padding zero
+        uint16_t szAlloc = (szPacket + 3) & ~3;
         if (pbuff) free(pbuff);
-        if (pbuff = static_cast<uint8_t *>(malloc(GECE_PSIZE))) {
-            memset(pbuff, 0, GECE_PSIZE);
+        if (pbuff = static_cast<uint8_t *>(malloc(szAlloc))) {
+            memset(pbuff, 0, szAlloc);
         } else {
             numPixels = 0;
             szBuffer = 0;
+            szPacket = 0;
             retval = false;
         }
-        szAsync = GECE_PSIZE;
     }
 
     if (asyncdata) free(asyncdata);
-    if (asyncdata = static_cast<uint8_t *>(malloc(szAsync))) {
-        memset(asyncdata, 0, szAsync);
+    if (asyncdata = static_cast<uint8_t *>(malloc(szBuffer))) {
+        memset(asyncdata, 0, szBuffer);
     } else {
         numPixels = 0;
         szBuffer = 0;
         retval = false;
     }
 
+    // Buffer size may have changed, setDither() must follow
+    setDither(false);
+
+    numSplit = numPixels;
+    updateRemap();
+
     if (type == PixelType::WS2811) {
-        refreshTime = WS2811_TFRAME * length + WS2811_TIDLE;
         ws2811_init();
     } else if (type == PixelType::GECE) {
-        refreshTime = (GECE_TFRAME + GECE_TIDLE) * length;
         gece_init();
+    } else if (type == PixelType::APA102) {
+        apa102_init();
     } else {
         retval = false;
     }
 
+    // After the init, APA102 needs its SPI clock set
+    updateRefresh();
+
     return retval;
 }
 
+/* Cut off any frame still going out, so no interrupt touches the buffers */
+void PixelDriver::stop() {
+    // timer1 is only ours with GECE, analogWrite() has it otherwise
+    if (type == PixelType::GECE)
+        timer1_disable();
+
+    // HSPI sends from its own registers, it only needs to stop being fed
+    if (type == PixelType::APA102) {
+        spiLeft = 0;
+        SPI.end();
+    }
+
+    uartTxIntDisable(UART);
+#if defined(ESPS_ENABLE_DUAL_OUTPUT)
+    uartTxIntDisable(UART_DUAL);
+#endif
+
+    uart_pending = 0;
+    uart_midframe[UART] = uart_midframe[UART_DUAL] = false;
+    gece_count = 0;
+}
+
+void PixelDriver::setSplit(uint16_t split, PixelColor color) {
+    if (!split || split > numPixels)
+        split = numPixels / 2;
+
+    // Both outputs share one buffer, so they must agree on channels per pixel
+    if (pixelChannels(color) != stride)
+        color = this->color;
+
+    numSplit = split;
+    updateOrder(color, UART_DUAL);
+    updateRefresh();
+}
+
+void PixelDriver::updateRefresh() {
+    if (type == PixelType::WS2811) {
+        // Both outputs run in parallel, the longer one sets the pace
+        uint16_t longest = std::max(numSplit, static_cast<uint16_t>(numPixels - numSplit));
+        refreshTime = WS2811_TCHANNEL * stride * longest + WS2811_TIDLE;
+    } else if (type == PixelType::GECE) {
+        refreshTime = (GECE_TFRAME + GECE_TIDLE) * numPixels;
+    } else if (type == PixelType::APA102) {
+        refreshTime = szPacket * 8000UL / (spiClock / 1000);
+    }
+}
+
+void PixelDriver::setDither(bool enable) {
+    free(errdata);
+    free(dithdata);
+    errdata = nullptr;
+    dithdata = nullptr;
+
+    dither = false;
+    if (!enable || type != PixelType::WS2811 || !szBuffer)
+        return;
+
+    // The dithered frame has its own buffer so getData() keeps source levels
+    errdata = static_cast<uint8_t *>(malloc(szBuffer));
+    dithdata = static_cast<uint8_t *>(malloc(szBuffer));
+    if (errdata && dithdata) {
+        memset(errdata, 0, szBuffer);
+        dither = true;
+    } else {
+        free(errdata);
+        free(dithdata);
+        errdata = nullptr;
+        dithdata = nullptr;
+    }
+}
+
+void PixelDriver::setGroup(uint16_t _group, uint16_t _zigzag) {
+    this->cntGroup = _group;
+    this->cntZigzag = _zigzag;
+    updateRemap();
+}
+
+/*
+* Build the physical to logical pixel map once so show() doesn't have to
+* divide its way through every LED on every frame. No map is kept when
+* grouping and zigzag are both off, show() does a straight copy instead.
+*/
+void PixelDriver::updateRemap() {
+    if (remap) {
+        free(remap);
+        remap = nullptr;
+    }
+
+    uint16_t group = cntGroup ? cntGroup : 1;
+    if ((group == 1 && !cntZigzag) || !numPixels)
+        return;
+
+    if (!(remap = static_cast<uint16_t *>(malloc(numPixels * sizeof(uint16_t)))))
+        return;
+
+    for (uint16_t led = 0; led < numPixels; led++) {
+        uint16_t this_led = led / group;
+        if (cntZigzag && (led / cntZigzag % 2)) { // Odd "zig"
+            uint16_t zig = cntZigzag * (led / cntZigzag);
+            this_led = (zig + cntZigzag - (led % cntZigzag) - 1) / group;
+        }
+
+        // A partial last zig can point past the end of the string
+        if (this_led >= numPixels)
+            this_led = numPixels - 1;
+
+        remap[led] = stride * this_led;
+    }
+}
+
 void PixelDriver::setPin(uint8_t pin) {
     if (this->pin >= 0)
         this->pin = pin;
@@ -106,194 +240,357 @@ void PixelDriver::setPin(uint8_t pin) {
 void PixelDriver::ws2811_init() {
     /* Serial rate is 4x 800KHz for WS2811 */
     Serial1.begin(3200000, SERIAL_6N1, SERIAL_TX_ONLY);
-    CLEAR_PERI_REG_MASK(UART_CONF0(UART), UART_INV_MASK);
-    SET_PERI_REG_MASK(UART_CONF0(UART), (BIT(22)));
 
-    /* Clear FIFOs */
-    SET_PERI_REG_MASK(UART_CONF0(UART), UART_RXFIFO_RST | UART_TXFIFO_RST);
-    CLEAR_PERI_REG_MASK(UART_CONF0(UART), UART_RXFIFO_RST | UART_TXFIFO_RST);
+#if defined(ESPS_ENABLE_DUAL_OUTPUT)
+    /* UART0 is taken over from the log port, so logging goes quiet from here */
+    Serial.end();
+    pinMode(1, SPECIAL);
+    uartConfig(UART_DUAL, 3200000, SERIAL_6N1);
+#endif
+
+    /* Atttach interrupt handler with interrupts masked */
+    uartAttachIsr(handleWS2811);
+
+    ws2811_uart_init(UART);
+#if defined(ESPS_ENABLE_DUAL_OUTPUT)
+    ws2811_uart_init(UART_DUAL);
+#endif
+
+    /* Reenable interrupts */
+    uartIsrEnable();
+}
 
-    /* Disable all interrupts */
-    ETS_UART_INTR_DISABLE();
+void PixelDriver::ws2811_uart_init(uint8_t uart) {
+    /* Invert TX */
+    uartInvertTx(uart);
 
-    /* Atttach interrupt handler */
-    ETS_UART_INTR_ATTACH(handleWS2811, NULL);
+    /* Clear FIFOs */
+    uartResetFifos(uart);
 
     /* Set TX FIFO trigger. 80 bytes gives 200 microsecs to refill the FIFO */
-    WRITE_PERI_REG(UART_CONF1(UART), 80 << UART_TXFIFO_EMPTY_THRHD_S);
+    uartSetTxThreshold(uart, 80);
 
     /* Disable RX & TX interrupts. It is enabled by uart.c in the SDK */
-    CLEAR_PERI_REG_MASK(UART_INT_ENA(UART), UART_RXFIFO_FULL_INT_ENA | UART_TXFIFO_EMPTY_INT_ENA);
-
-    /* Clear all pending interrupts in UART1 */
-    WRITE_PERI_REG(UART_INT_CLR(UART), 0xffff);
+    uartIntDisableAll(uart);
 
-    /* Reenable interrupts */
-    ETS_UART_INTR_ENABLE();
+    /* Clear all pending interrupts */
+    uartIntClear(uart);
 }
 
 void PixelDriver::gece_init() {
     // Serial rate is 3x 100KHz for GECE
     Serial1.begin(300000, SERIAL_7N1, SERIAL_TX_ONLY);
-    SET_PERI_REG_MASK(UART_CONF0(UART), UART_TXD_BRK);
+    uartSetBreak(UART, true);
     delayMicroseconds(GECE_TIDLE);
+
+    // Bulbs are clocked out from timer1 so show() doesn't block
+    timer1_disable();
+    timer1_isr_init();
+    timer1_attachInterrupt(handleGECE);
 }
 
-void PixelDriver::updateOrder(PixelColor color) {
-    this->color = color;
+void PixelDriver::apa102_init() {
+    if (!spiClock)
+        spiClock = APA102_DEFAULT_CLOCK;
+    if (!spiBright)
+        spiBright = APA102_MAX_BRIGHTNESS;
+
+    // HSPI - GPIO13 data, GPIO14 clock
+    SPI.begin();
+    SPI.setDataMode(SPI_MODE0);
+    SPI.setBitOrder(MSBFIRST);
+    SPI.setFrequency(spiClock);
+}
+
+void PixelDriver::setSPI(uint32_t clock, uint8_t brightness) {
+    spiClock = clock ? clock : APA102_DEFAULT_CLOCK;
+    spiBright = std::min(brightness, static_cast<uint8_t>(APA102_MAX_BRIGHTNESS));
 
+    if (type == PixelType::APA102) {
+        SPI.setFrequency(spiClock);
+        updateRefresh();
+    }
+}
+
+void PixelDriver::updateOrder(PixelColor color, uint8_t uart) {
+    if (uart == UART)
+        this->color = color;
+
+    // Source byte for each channel in the order it goes out on the wire
+    uint8_t *o = offset[uart];
     switch (color) {
         case PixelColor::GRB:
-            rOffset = 1;
-            gOffset = 0;
-            bOffset = 2;
+            o[0] = 1; o[1] = 0; o[2] = 2;
             break;
         case PixelColor::BRG:
-            rOffset = 1;
-            gOffset = 2;
-            bOffset = 0;
+            o[0] = 1; o[1] = 2; o[2] = 0;
             break;
         case PixelColor::RBG:
-            rOffset = 0;
-            gOffset = 2;
-            bOffset = 1;
+            o[0] = 0; o[1] = 2; o[2] = 1;
             break;
         case PixelColor::GBR:
-            rOffset = 2;
-            gOffset = 0;
-            bOffset = 1;
+            o[0] = 2; o[1] = 0; o[2] = 1;
             break;
         case PixelColor::BGR:
-            rOffset = 2;
-            gOffset = 1;
-            bOffset = 0;
+            o[0] = 2; o[1] = 1; o[2] = 0;
+            break;
+        case PixelColor::GRBW:
+            o[0] = 1; o[1] = 0; o[2] = 2; o[3] = 3;
+            break;
+        case PixelColor::RGBW:
+            o[0] = 0; o[1] = 1; o[2] = 2; o[3] = 3;
             break;
         default:
-            rOffset = 0;
-            gOffset = 1;
-            bOffset = 2;
+            o[0] = 0; o[1] = 1; o[2] = 2;
     }
 }
 
 void ICACHE_RAM_ATTR PixelDriver::handleWS2811(void *param) {
+    uint32_t start = _getCycleCount();
+
     /* Process if UART1 */
-    if (READ_PERI_REG(UART_INT_ST(UART1))) {
-        // Fill the FIFO with new data
-        uart_buffer = fillWS2811(uart_buffer, uart_buffer_tail);
+    if (uartIntPending(UART1))
+        handleWS2811Uart(UART1);
+
+#if defined(ESPS_ENABLE_DUAL_OUTPUT)
+    /* Process if UART0 */
+    if (uartIntPending(UART0))
+        handleWS2811Uart(UART0);
+#else
+    /* Clear if UART0 */
+    if (uartIntPending(UART0))
+        uartIntClear(UART0);
+#endif
 
-        // Disable TX interrupt when done
-        if (uart_buffer == uart_buffer_tail)
-            CLEAR_PERI_REG_MASK(UART_INT_ENA(UART1), UART_TXFIFO_EMPTY_INT_ENA);
+    trackIsr(_getCycleCount() - start);
+}
 
-        // Clear all interrupts flags (just in case)
-        WRITE_PERI_REG(UART_INT_CLR(UART1), 0xffff);
+void ICACHE_RAM_ATTR PixelDriver::handleWS2811Uart(uint8_t uart) {
+    // An empty FIFO after the first fill means the line went idle and the
+    // string may have latched a partial frame
+    if (uart_midframe[uart] && !uartTxFifoLength(uart))
+        stats.underruns++;
+
+    // Fill the FIFO with new data
+    uart_buffer[uart] = fillWS2811(uart, uart_buffer[uart], uart_buffer_tail[uart]);
+    uart_midframe[uart] = true;
+
+    // Disable TX interrupt when done
+    if (uart_buffer[uart] == uart_buffer_tail[uart]) {
+        uartTxIntDisable(uart);
+        uart_midframe[uart] = false;
+        if (uart_pending && !(uart_pending &= ~(1 << uart)))
+            stats.frames_done++;
     }
 
-    /* Clear if UART0 */
-    if (READ_PERI_REG(UART_INT_ST(UART0)))
-        WRITE_PERI_REG(UART_INT_CLR(UART0), 0xffff);
+    // Clear all interrupts flags (just in case)
+    uartIntClear(uart);
+}
+
+/*
+* GECE bulbs are sent as a two step timer1 state machine:
+*   start bit - release the break for 10us
+*   packet    - queue the 26 symbols, break is reasserted once the FIFO
+*               drains, then wait out the rest of the frame and idle time
+*/
+void ICACHE_RAM_ATTR PixelDriver::handleGECE() {
+    uint32_t start = _getCycleCount();
+
+    if (gece_startbit) {
+        uartSetBreak(UART, false);
+        gece_startbit = false;
+        timer1_write(GECE_TSTART * GECE_TICKS_US);
+    } else {
+        for (uint8_t i = 0; i < GECE_PSIZE; i++)
+            uartWrite(UART, gece_packet[i]);
+        uartSetBreak(UART, true);
+
+        if (++gece_bulb < gece_count) {
+            packGECE(gece_packet, gece_buffer, gece_bulb);
+            gece_startbit = true;
+            timer1_write((GECE_TFRAME + GECE_TIDLE - GECE_TSTART) * GECE_TICKS_US);
+        } else {
+            timer1_disable();
+            stats.frames_done++;
+        }
+    }
+
+    trackIsr(_getCycleCount() - start);
+}
+
+void ICACHE_RAM_ATTR PixelDriver::packGECE(uint8_t *pbuff,
+        const uint8_t *buff, uint8_t bulb) {
+    uint32_t packet = 0;
+
+    // Build a GECE packet
+    packet = (packet & ~GECE_ADDRESS_MASK) | (bulb << 20);
+    packet = (packet & ~GECE_BRIGHTNESS_MASK) |
+            (GECE_DEFAULT_BRIGHTNESS << 12);
+    packet = (packet & ~GECE_BLUE_MASK) | (buff[bulb*3+2] << 4);
+    packet = (packet & ~GECE_GREEN_MASK) | buff[bulb*3+1];
+    packet = (packet & ~GECE_RED_MASK) | (buff[bulb*3] >> 4);
+
+    uint8_t shift = GECE_PSIZE;
+    for (uint8_t i = 0; i < GECE_PSIZE; i++)
+        pbuff[i] = LOOKUP_GECE[(packet >> --shift) & 0x1];
+}
+
+uint16_t PixelDriver::encodeAPA102(uint8_t *out, const uint8_t *in,
+        uint16_t count, const uint8_t *order, uint8_t brightness) {
+    uint8_t *p = out;
+
+    // Start frame
+    for (uint8_t i = 0; i < 4; i++)
+        *p++ = 0x00;
+
+    const uint8_t header = APA102_HEADER | (brightness & APA102_MAX_BRIGHTNESS);
+    for (uint16_t led = 0; led < count; led++) {
+        *p++ = header;
+        *p++ = GAMMA_TABLE[in[order[0]]] >> GAMMA_SHIFT;
+        *p++ = GAMMA_TABLE[in[order[1]]] >> GAMMA_SHIFT;
+        *p++ = GAMMA_TABLE[in[order[2]]] >> GAMMA_SHIFT;
+        in += 3;
+    }
+
+    // End frame - SK9822 latches on 32 zeros, APA102 needs the extra clocks
+    uint16_t tail = 4 + (count + 15) / 16;
+    memset(p, 0x00, tail);
+    p += tail;
+
+    return p - out;
 }
 
-const uint8_t* ICACHE_RAM_ATTR PixelDriver::fillWS2811(const uint8_t *buff,
-        const uint8_t *tail) {
-    uint8_t avail = (UART_TX_FIFO_SIZE - getFifoLength()) / 4;
+const uint8_t* ICACHE_RAM_ATTR PixelDriver::fillWS2811(uint8_t uart,
+        const uint8_t *buff, const uint8_t *tail) {
+    uint8_t avail = uartTxFifoFree(uart) / 4;
     if (tail - buff > avail)
         tail = buff + avail;
 
-    while (buff + 2 < tail) {
-        uint8_t subpix = buff[rOffset];
-        enqueue(LOOKUP_2811[(GAMMA_TABLE[subpix] >> (6+GAMMA_SHIFT)) & 0x3]);
-        enqueue(LOOKUP_2811[(GAMMA_TABLE[subpix] >> (4+GAMMA_SHIFT)) & 0x3]);
-        enqueue(LOOKUP_2811[(GAMMA_TABLE[subpix] >> (2+GAMMA_SHIFT)) & 0x3]);
-        enqueue(LOOKUP_2811[(GAMMA_TABLE[subpix] >> (0+GAMMA_SHIFT)) & 0x3]);
-
-        subpix = buff[gOffset];
-        enqueue(LOOKUP_2811[(GAMMA_TABLE[subpix] >> (6+GAMMA_SHIFT)) & 0x3]);
-        enqueue(LOOKUP_2811[(GAMMA_TABLE[subpix] >> (4+GAMMA_SHIFT)) & 0x3]);
-        enqueue(LOOKUP_2811[(GAMMA_TABLE[subpix] >> (2+GAMMA_SHIFT)) & 0x3]);
-        enqueue(LOOKUP_2811[(GAMMA_TABLE[subpix] >> (0+GAMMA_SHIFT)) & 0x3]);
-
-        subpix = buff[bOffset];
-        enqueue(LOOKUP_2811[(GAMMA_TABLE[subpix] >> (6+GAMMA_SHIFT)) & 0x3]);
-        enqueue(LOOKUP_2811[(GAMMA_TABLE[subpix] >> (4+GAMMA_SHIFT)) & 0x3]);
-        enqueue(LOOKUP_2811[(GAMMA_TABLE[subpix] >> (2+GAMMA_SHIFT)) & 0x3]);
-        enqueue(LOOKUP_2811[(GAMMA_TABLE[subpix] >> (0+GAMMA_SHIFT)) & 0x3]);
-
-        buff += 3;
+    const uint8_t *o = offset[uart];
+    const uint8_t n = stride;
+    while (buff + n <= tail) {
+        for (uint8_t i = 0; i < n; i++)
+            enqueueSymbol(uart, GAMMA_2811[buff[o[i]]]);
+        buff += n;
     }
 
     return buff;
 }
 
+void ICACHE_RAM_ATTR PixelDriver::copyFrame() {
+    if (!remap) {  // Straight copy
+        memcpy(asyncdata, pixdata, szBuffer);
+    } else {  // Group / zigzag copy
+        uint8_t *dst = asyncdata;
+        for (uint16_t led = 0; led < numPixels; led++) {
+            const uint8_t *src = pixdata + remap[led];
+            for (uint8_t i = 0; i < stride; i++)
+                *dst++ = src[i];
+        }
+    }
+}
+
 void ICACHE_RAM_ATTR PixelDriver::show() {
     if (!pixdata) return;
 
+    shownGen = frameGen;
+    stats.frames_shown++;
+
+    // Achieved frame rate, once a second
+    uint32_t now = millis();
+    if (now - rateStart >= 1000) {
+        stats.fps = (stats.frames_done - rateFrames) * 1000 / (now - rateStart);
+        rateStart = now;
+        rateFrames = stats.frames_done;
+    }
+
     if (type == PixelType::WS2811) {
-        if (!cntZigzag) {  // Normal / group copy
-            for (size_t led = 0; led < szBuffer / 3; led++) {
-                uint16 modifier = led / cntGroup;
-                asyncdata[3 * led + 0] = pixdata[3 * modifier + 0];
-                asyncdata[3 * led + 1] = pixdata[3 * modifier + 1];
-                asyncdata[3 * led + 2] = pixdata[3 * modifier + 2];
-            }
-        } else {  // Zigzag copy
-            for (size_t led = 0; led < szBuffer / 3; led++) {
-                uint16 modifier = led / cntGroup;
-                if (led / cntZigzag % 2) { // Odd "zig"
-                    int group = cntZigzag * (led / cntZigzag);
-                    int this_led = (group + cntZigzag - (led % cntZigzag) - 1) / cntGroup;
-                    asyncdata[3 * led + 0] = pixdata[3 * this_led + 0];
-                    asyncdata[3 * led + 1] = pixdata[3 * this_led + 1];
-                    asyncdata[3 * led + 2] = pixdata[3 * this_led + 2];
-                } else { // Even "zag"
-                    asyncdata[3 * led + 0] = pixdata[3 * modifier + 0];
-                    asyncdata[3 * led + 1] = pixdata[3 * modifier + 1];
-                    asyncdata[3 * led + 2] = pixdata[3 * modifier + 2];
-                }
+        copyFrame();
+
+        /*
+        * Apply the 16 bit gamma here and carry what's below the top byte
+        * over to the next frame. The UART symbols are linear in this mode.
+        */
+        uint8_t *out = asyncdata;
+        if (dither) {
+            for (uint16_t i = 0; i < szBuffer; i++) {
+                uint32_t acc = GAMMA_TABLE[asyncdata[i]] + errdata[i];
+                dithdata[i] = (acc > 0xFFFF) ? 0xFF : acc >> GAMMA_SHIFT;
+                errdata[i] = acc;
             }
-
+            out = dithdata;
         }
 
-        uart_buffer = asyncdata;
-        uart_buffer_tail = asyncdata + szBuffer;
+        uart_buffer[UART] = out;
+        uart_buffer_tail[UART] = out + numSplit * stride;
+        uart_midframe[UART] = false;
+        uart_pending = 1 << UART;
+
+#if defined(ESPS_ENABLE_DUAL_OUTPUT)
+        uart_buffer[UART_DUAL] = uart_buffer_tail[UART];
+        uart_buffer_tail[UART_DUAL] = out + szBuffer;
+        uart_midframe[UART_DUAL] = false;
+        uart_pending |= 1 << UART_DUAL;
+        uartTxIntEnable(UART_DUAL);
+#endif
+        uartTxIntEnable(UART);
 
-        SET_PERI_REG_MASK(UART_INT_ENA(1), UART_TXFIFO_EMPTY_INT_ENA);
         startTime = micros();
 
     } else if (type == PixelType::GECE) {
-        uint32_t packet = 0;
-        uint32_t pTime = 0;
+        if (!numPixels) return;
+
+        // Snapshot the frame so updates don't land mid transmit
+        memcpy(asyncdata, pixdata, szBuffer);
+
+        gece_buffer = asyncdata;
+        gece_packet = pbuff;
+        gece_count = numPixels;
+        gece_bulb = 0;
+        packGECE(gece_packet, gece_buffer, gece_bulb);
 
-        // Build a GECE packet
+        // First start bit after the minimum idle time
+        gece_startbit = true;
         startTime = micros();
-        for (uint8_t i = 0; i < numPixels; i++) {
-            packet = (packet & ~GECE_ADDRESS_MASK) | (i << 20);
-            packet = (packet & ~GECE_BRIGHTNESS_MASK) |
-                    (GECE_DEFAULT_BRIGHTNESS << 12);
-            packet = (packet & ~GECE_BLUE_MASK) | (pixdata[i*3+2] << 4);
-            packet = (packet & ~GECE_GREEN_MASK) | pixdata[i*3+1];
-            packet = (packet & ~GECE_RED_MASK) | (pixdata[i*3] >> 4);
-
-            uint8_t shift = GECE_PSIZE;
-            for (uint8_t i = 0; i < GECE_PSIZE; i++)
-                pbuff[i] = LOOKUP_GECE[(packet >> --shift) & 0x1];
-
-            // Wait until ready
-            while ((micros() - pTime) < (GECE_TFRAME + GECE_TIDLE)) {}
-
-            // 10us start bit
-            pTime = micros();
-            uint32_t c = _getCycleCount();
-            CLEAR_PERI_REG_MASK(UART_CONF0(UART), UART_TXD_BRK);
-            while ((_getCycleCount() - c) < CYCLES_GECE_START - 100) {}
-
-            // Send packet and idle low (break)
-            Serial1.write(pbuff, GECE_PSIZE);
-            SET_PERI_REG_MASK(UART_CONF0(UART), UART_TXD_BRK);
-        }
+        timer1_enable(TIM_DIV16, TIM_EDGE, TIM_SINGLE);
+        timer1_write(GECE_TIDLE * GECE_TICKS_US);
+
+    } else if (type == PixelType::APA102) {
+        copyFrame();
+
+        // Clocked pixels have no timing to hold, update() hands HSPI the rest
+        spiLeft = encodeAPA102(pbuff, asyncdata, numPixels, offset[UART], spiBright);
+        spiNext = pbuff;
+        startTime = micros();
+        update();
     }
 }
 
+/*
+* HSPI takes SPI_CHUNK bytes at a time. Load the next chunk each time the
+* last one is out, for up to APA102_SLICE, so loop() keeps going on long
+* strings. A 2048 pixel frame is 16ms at 4MHz.
+*/
+void PixelDriver::update() {
+    if (!spiLeft)
+        return;
+
+    uint32_t start = micros();
+    do {
+        if (spiBusy())
+            continue;
+
+        uint8_t len = std::min(spiLeft, static_cast<uint16_t>(SPI_CHUNK));
+        spiWrite(spiNext, len);
+        spiNext += len;
+        spiLeft -= len;
+        if (!spiLeft) {
+            stats.frames_done++;
+            return;
+        }
+    } while (micros() - start < APA102_SLICE);
+}
+
 uint8_t* PixelDriver::getData() {
     return asyncdata;	// data post grouping or zigzaging
 //    return pixdata;
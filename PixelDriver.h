@@ -20,8 +20,11 @@
 #ifndef PIXELDRIVER_H_
 #define PIXELDRIVER_H_
 
-#define UART_INV_MASK  (0x3f << 19)
-#define UART 1
+#include "UartHal.h"
+#include "SpiHal.h"
+
+#define UART 1      /* Primary output */
+#define UART_DUAL 0 /* Second output when ESPS_ENABLE_DUAL_OUTPUT is set */
 
 /* Gamma correction table */
 #include "gamma.h"
@@ -63,19 +66,43 @@ const char LOOKUP_GECE[2] = {
 #define GECE_GET_RED(packet)        packet & 0x0F
 #define GECE_PSIZE                  26
 
-#define WS2811_TFRAME   30L     /* 30us frame time */
+#define WS2811_TCHANNEL 10L     /* 10us per channel, 30us for an RGB pixel */
 #define WS2811_TIDLE    300L    /* 300us idle time */
 #define GECE_TFRAME     790L    /* 790us frame time */
 #define GECE_TIDLE      45L     /* 45us idle time - should be 30us */
 
-#define CYCLES_GECE_START   (F_CPU / 100000) // 10us
+#define APA102_DEFAULT_CLOCK    4000000L    /* 4MHz SPI clock */
+#define APA102_MAX_CLOCK        20000000L   /* Fastest HSPI clock that holds up over a few meters */
+#define APA102_MAX_BRIGHTNESS   31          /* 5 bit global brightness */
+#define APA102_HEADER           0xE0        /* Top 3 bits of every LED frame */
+#define APA102_SLICE            500L        /* Most us one update() spends feeding HSPI */
+
+/* Start frame, 4 bytes per pixel and end frame with half a clock per pixel */
+#define APA102_SIZE(pixels)     (4 + 4 * (pixels) + 4 + ((pixels) + 15) / 16)
+
+#define GECE_TSTART     10L     /* 10us start bit */
+#define GECE_TICKS_US   5       /* timer1 ticks per microsecond at TIM_DIV16 */
 
 /* Pixel Types */
 enum class PixelType : uint8_t {
     WS2811,
-    GECE
+    GECE,
+    APA102
 };
 
+/* Output statistics */
+typedef struct {
+    uint32_t    frames_shown;   // Frames transmitted
+    uint32_t    frames_skipped; // Refresh slots skipped because nothing changed
+    uint32_t    frames_done;    // Frames fully clocked out
+    uint32_t    fps;            // Frames done per second, updated once a second
+    uint32_t    underruns;      // TX FIFO found empty part way through a frame
+    uint32_t    isr_count;      // Output interrupts handled
+    uint32_t    isr_min;        // Shortest interrupt in CPU cycles
+    uint32_t    isr_avg;        // Running average interrupt in CPU cycles
+    uint32_t    isr_max;        // Longest interrupt in CPU cycles
+} pixel_stats_t;
+
 /* Color Order */
 enum class PixelColor : uint8_t {
     RGB,
@@ -83,22 +110,49 @@ enum class PixelColor : uint8_t {
     BRG,
     RBG,
     GBR,
-    BGR
+    BGR,
+    RGBW,
+    GRBW
 };
 
+#define PIXEL_MAX_CHANNELS  4   /* Largest number of channels per pixel */
+
+/* Number of channels per pixel for a color order */
+inline uint8_t pixelChannels(PixelColor color) {
+    return color >= PixelColor::RGBW ? 4 : 3;
+}
+
 class PixelDriver {
  public:
+    static pixel_stats_t    stats;  // Statistics tracker, shared with the ISRs
+
     int begin();
     int begin(PixelType type);
     int begin(PixelType type, PixelColor color, uint16_t length);
     void setPin(uint8_t pin);
-    void updateOrder(PixelColor color);
+    void setSPI(uint32_t clock, uint8_t brightness);
+    void updateOrder(PixelColor color, uint8_t uart = UART);
     void ICACHE_RAM_ATTR show();
     uint8_t* getData();
 
+    /* Feed the frame show() started to HSPI, call from loop(). APA102 only */
+    void update();
+
+    /* Channels per pixel */
+    inline uint8_t getChannels() {
+        return stride;
+    }
+
     /* Set channel value at address */
     inline void setValue(uint16_t address, uint8_t value) {
         pixdata[address] = value;
+        frameGen++;
+    }
+
+    /* Copy a whole frame in from channel 0 */
+    inline void setData(const uint8_t *data, uint16_t length) {
+        memcpy(pixdata, data, length < szBuffer ? length : szBuffer);
+        frameGen++;
     }
 
     /* Get channel value at address */
@@ -106,17 +160,54 @@ class PixelDriver {
         return pixdata[address];
     }
 
-    /* Set group / zigzag counts */
-    inline void setGroup(uint16_t _group, uint16_t _zigzag) {
-        this->cntGroup = _group;
-        this->cntZigzag = _zigzag;
-    }
+    /* Set group / zigzag counts and rebuild the output map */
+    void setGroup(uint16_t _group, uint16_t _zigzag);
 
-    /* Drop the update if our refresh rate is too high */
+    /* Split the string between UART and UART_DUAL - first output gets split pixels */
+    void setSplit(uint16_t split, PixelColor color);
+
+    /* Drop the update if our refresh rate is too high, or HSPI is still being fed */
     inline bool canRefresh() {
-        return (micros() - startTime) >= refreshTime;
+        return !spiLeft && (micros() - startTime) >= refreshTime;
+    }
+
+    /* Flag the frame as changed after writing to it through getData() */
+    inline void markDirty() {
+        frameGen++;
+    }
+
+    /* Has the frame changed since it was last shown - a dithered frame always has */
+    inline bool isDirty() {
+        return dither || frameGen != shownGen;
+    }
+
+    /* Spread the low gamma byte across frames, WS2811 only */
+    void setDither(bool enable);
+
+    inline bool isDithering() {
+        return dither;
+    }
+
+    /*
+    * Give up this refresh slot, the frame hasn't changed. Counted once a
+    * refresh time, startTime stays with the last frame actually sent.
+    */
+    inline void skip() {
+        uint32_t now = micros();
+        if (now - skipTime >= refreshTime) {
+            skipTime = now;
+            stats.frames_skipped++;
+        }
     }
 
+    /*
+    * Encode count pixels from in as an APA102 / SK9822 SPI frame. Channels
+    * go out in order, gamma corrected. Returns bytes written to out, which
+    * must hold APA102_SIZE(count).
+    */
+    static uint16_t encodeAPA102(uint8_t *out, const uint8_t *in,
+            uint16_t count, const uint8_t *order, uint8_t brightness);
+
  private:
     PixelType   type;           // Pixel type
     PixelColor  color;          // Color Order
@@ -125,42 +216,85 @@ class PixelDriver {
     uint8_t     pin;            // Pin for bit-banging
     uint8_t     *pixdata;       // Pixel buffer
     uint8_t     *asyncdata;     // Async buffer
-    uint8_t     *pbuff;         // GECE Packet Buffer
+    uint16_t    *remap;         // Physical pixel to pixdata offset map, NULL for 1:1
+    uint8_t     *errdata;       // Dither error accumulator, one per channel
+    uint8_t     *dithdata;      // Dithered output, sent in place of asyncdata
+    bool        dither;         // Temporal dithering enabled
+    uint8_t     *pbuff;         // GECE / APA102 Packet Buffer
+    uint16_t    szPacket;       // Size of Packet buffer
+    uint32_t    spiClock;       // APA102 SPI clock in Hz
+    uint8_t     spiBright;      // APA102 global brightness
+    const uint8_t *spiNext;     // Next APA102 byte for HSPI
+    uint16_t    spiLeft;        // APA102 bytes still to go to HSPI
     uint16_t    numPixels;      // Number of pixels
+    uint16_t    numSplit;       // Number of pixels on the first output
     uint16_t    szBuffer;       // Size of Pixel buffer
+    static uint8_t    stride;       // Channels per pixel
     uint32_t    startTime;      // When the last frame TX started
+    uint32_t    skipTime;       // When a refresh slot was last counted as skipped
     uint32_t    refreshTime;    // Time until we can refresh after starting a TX
-    static uint8_t    rOffset;  // Index of red byte
-    static uint8_t    gOffset;  // Index of green byte
-    static uint8_t    bOffset;  // Index of blue byte
+    uint32_t    frameGen;       // Frame generation, bumped on every write
+    uint32_t    shownGen;       // Frame generation at the last show()
+    uint32_t    rateStart;      // When the current frame rate window started, in millis
+    uint32_t    rateFrames;     // frames_done at the start of the window
+    static uint8_t    offset[2][PIXEL_MAX_CHANNELS];  // Source byte for each channel sent, per UART
 
+    void stop();
     void ws2811_init();
+    void ws2811_uart_init(uint8_t uart);
+    void updateRemap();
+    void updateRefresh();
+    void ICACHE_RAM_ATTR copyFrame();
     void gece_init();
+    void apa102_init();
 
     /* FIFO Handlers */
-    static const uint8_t* ICACHE_RAM_ATTR fillWS2811(const uint8_t *buff,
-            const uint8_t *tail);
+    static const uint8_t* ICACHE_RAM_ATTR fillWS2811(uint8_t uart,
+            const uint8_t *buff, const uint8_t *tail);
+
+    /* GECE packet builder */
+    static void ICACHE_RAM_ATTR packGECE(uint8_t *pbuff, const uint8_t *buff,
+            uint8_t bulb);
 
     /* Interrupt Handlers */
     static void ICACHE_RAM_ATTR handleWS2811(void *param);
+    static void ICACHE_RAM_ATTR handleWS2811Uart(uint8_t uart);
+    static void ICACHE_RAM_ATTR handleGECE();
 
-    /* Returns number of bytes waiting in the TX FIFO of UART1 */
-    static inline uint8_t getFifoLength() {
-        return (U1S >> USTXC) & 0xff;
+    /* Fold one interrupt's run time into the stats, average weighs 1/16 */
+    static inline void trackIsr(uint32_t cycles) {
+        if (!stats.isr_count++) {
+            stats.isr_min = stats.isr_avg = stats.isr_max = cycles;
+            return;
+        }
+        if (cycles < stats.isr_min)
+            stats.isr_min = cycles;
+        if (cycles > stats.isr_max)
+            stats.isr_max = cycles;
+        stats.isr_avg += static_cast<int32_t>(cycles - stats.isr_avg) / 16;
     }
 
-    /* Append a byte to the TX FIFO of UART1 */
-    static inline void enqueue(uint8_t byte) {
-        U1F = byte;
+    /* Append a pre-encoded WS2811 symbol word to the TX FIFO of uart, LSB first */
+    static inline void enqueueSymbol(uint8_t uart, uint32_t symbol) {
+        uartWrite(uart, symbol);
+        uartWrite(uart, symbol >> 8);
+        uartWrite(uart, symbol >> 16);
+        uartWrite(uart, symbol >> 24);
     }
 };
 
 // Cycle counter
 static uint32_t _getCycleCount(void) __attribute__((always_inline));
+#if defined(ESPS_HOST)
+static inline uint32_t _getCycleCount(void) {
+    return simCycleCount();
+}
+#else
 static inline uint32_t _getCycleCount(void) {
     uint32_t ccount;
     __asm__ __volatile__("rsr %0,ccount":"=a" (ccount));
     return ccount;
 }
+#endif
 
 #endif /* PIXELDRIVER_H_ */
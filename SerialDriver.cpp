@@ -28,12 +28,19 @@ GNU General Public License for more details.
 #include <math.h>
 #include "SerialDriver.h"
 
-extern "C" {
-#include <eagle_soc.h>
-#include <ets_sys.h>
-#include <uart.h>
-#include <uart_register.h>
-}
+/* Identity apart from 0x7D -> 0x7C and 0x7E, 0x7F -> 0x80 */
+#define RENARD_ROW(n) \
+    n+0x0, n+0x1, n+0x2, n+0x3, n+0x4, n+0x5, n+0x6, n+0x7, \
+    n+0x8, n+0x9, n+0xA, n+0xB, n+0xC, n+0xD, n+0xE, n+0xF
+
+const uint8_t RENARD_LUT[256] = {
+    RENARD_ROW(0x00), RENARD_ROW(0x10), RENARD_ROW(0x20), RENARD_ROW(0x30),
+    RENARD_ROW(0x40), RENARD_ROW(0x50), RENARD_ROW(0x60),
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77,
+    0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7C, 0x80, 0x80,
+    RENARD_ROW(0x80), RENARD_ROW(0x90), RENARD_ROW(0xA0), RENARD_ROW(0xB0),
+    RENARD_ROW(0xC0), RENARD_ROW(0xD0), RENARD_ROW(0xE0), RENARD_ROW(0xF0)
+};
 
 /* Uart Buffer tracker */
 static const uint8_t *uart_buffer;
@@ -95,26 +102,22 @@ int SerialDriver::begin(HardwareSerial *theSerial, SerialType type,
     }
 
     /* Clear FIFOs */
-    SET_PERI_REG_MASK(UART_CONF0(SEROUT_UART), UART_RXFIFO_RST | UART_TXFIFO_RST);
-    CLEAR_PERI_REG_MASK(UART_CONF0(SEROUT_UART), UART_RXFIFO_RST | UART_TXFIFO_RST);
-
-    /* Disable all interrupts */
-    ETS_UART_INTR_DISABLE();
+    uartResetFifos(SEROUT_UART);
 
-    /* Atttach interrupt handler */
-    ETS_UART_INTR_ATTACH(serial_handle, NULL);
+    /* Atttach interrupt handler with interrupts masked */
+    uartAttachIsr(serial_handle);
 
     /* Set TX FIFO trigger. 80 bytes gives 200 microsecs to refill the FIFO */
-    WRITE_PERI_REG(UART_CONF1(SEROUT_UART), 80 << UART_TXFIFO_EMPTY_THRHD_S);
+    uartSetTxThreshold(SEROUT_UART, 80);
 
     /* Disable RX & TX interrupts. It is enabled by uart.c in the SDK */
-    CLEAR_PERI_REG_MASK(UART_INT_ENA(SEROUT_UART), UART_RXFIFO_FULL_INT_ENA | UART_TXFIFO_EMPTY_INT_ENA);
+    uartIntDisableAll(SEROUT_UART);
 
     /* Clear all pending interrupts in SEROUT_UART */
-    WRITE_PERI_REG(UART_INT_CLR(SEROUT_UART), 0xffff);
+    uartIntClear(SEROUT_UART);
 
     /* Reenable interrupts */
-    ETS_UART_INTR_ENABLE();
+    uartIsrEnable();
 
     return retval;
 }
@@ -133,34 +136,34 @@ void SerialDriver::startPacket() {
 }
 
 const uint8_t* ICACHE_RAM_ATTR SerialDriver::fillFifo(const uint8_t *buff, const uint8_t *tail) {
-    uint8_t avail = (UART_TX_FIFO_SIZE - getFifoLength());
+    uint8_t avail = uartTxFifoFree(SEROUT_UART);
     if (tail - buff > avail) tail = buff + avail;
-    while (buff < tail) enqueue(*buff++);
+    while (buff < tail) uartWrite(SEROUT_UART, *buff++);
     return buff;
 }
 
 void ICACHE_RAM_ATTR SerialDriver::serial_handle(void *param) {
     /* Process and clear SEROUT_UART */
-    if (READ_PERI_REG(UART_INT_ST(SEROUT_UART))) {
+    if (uartIntPending(SEROUT_UART)) {
         // Fill the FIFO with new data
         uart_buffer = fillFifo(uart_buffer, uart_buffer_tail);
 
         // Clear TX interrupt when done
         if (uart_buffer == uart_buffer_tail)
-            CLEAR_PERI_REG_MASK(UART_INT_ENA(SEROUT_UART), UART_TXFIFO_EMPTY_INT_ENA);
+            uartTxIntDisable(SEROUT_UART);
 
         // Clear all interrupts flags (just in case)
-        WRITE_PERI_REG(UART_INT_CLR(SEROUT_UART), 0xffff);
+        uartIntClear(SEROUT_UART);
     }
 
 #if SEROUT_UART == 0
     /* Clear UART1 if needed */
-    if (READ_PERI_REG(UART_INT_ST(UART1)))
-        WRITE_PERI_REG(UART_INT_CLR(UART1), 0xffff);
+    if (uartIntPending(UART1))
+        uartIntClear(UART1);
 #elif SEROUT_UART == 1
     /* Clear if UART0 if needed */
-    if (READ_PERI_REG(UART_INT_ST(UART0)))
-        WRITE_PERI_REG(UART_INT_CLR(UART0), 0xffff);
+    if (uartIntPending(UART0))
+        uartIntClear(UART0);
 #endif
 }
 
@@ -168,17 +171,20 @@ void ICACHE_RAM_ATTR SerialDriver::serial_handle(void *param) {
 void SerialDriver::show() {
     if (!_serialdata) return;
 
+    _shownGen = _frameGen;
+    stats.frames_shown++;
+
     uart_buffer = _serialdata;
     uart_buffer_tail = _serialdata + _size;
 
     if (_type == SerialType::DMX512) {
-        SET_PERI_REG_MASK(UART_CONF0(SEROUT_UART), UART_TXD_BRK);
+        uartSetBreak(SEROUT_UART, true);
         delayMicroseconds(DMX_BREAK);
-        CLEAR_PERI_REG_MASK(UART_CONF0(SEROUT_UART), UART_TXD_BRK);
+        uartSetBreak(SEROUT_UART, false);
         delayMicroseconds(DMX_MAB);
     }
 
-    SET_PERI_REG_MASK(UART_INT_ENA(SEROUT_UART), UART_TXFIFO_EMPTY_INT_ENA);
+    uartTxIntEnable(SEROUT_UART);
 
     startTime = micros();
 
@@ -188,6 +194,21 @@ void SerialDriver::show() {
 }
 
 
+void SerialDriver::setData(const uint8_t *data, uint16_t length) {
+    if (!_serialdata) return;
+
+    if (_type == SerialType::RENARD) {
+        length = std::min(length, static_cast<uint16_t>(_size - 2));
+        uint8_t *dst = _serialdata + 2;
+        for (uint16_t i = 0; i < length; i++)
+            dst[i] = RENARD_LUT[data[i]];
+    } else if (_type == SerialType::DMX512) {
+        length = std::min(length, static_cast<uint16_t>(_size - 1));
+        memcpy(_serialdata + 1, data, length);
+    }
+    _frameGen++;
+}
+
 uint8_t* SerialDriver::getData() {
     return _serialdata;
 }
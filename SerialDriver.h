@@ -27,6 +27,7 @@ GNU General Public License for more details.
 #define SERIALDRIVER_H_
 
 #include "HardwareSerial.h"
+#include "UartHal.h"
 
 /* UART for Renard / DMX output */
 #define SEROUT_UART 1
@@ -58,8 +59,19 @@ enum class BaudRate : uint32_t {
     BR_460800 = 460800
 };
 
+/* Renard value with the sync / escape characters rounded away */
+extern const uint8_t RENARD_LUT[256];
+
+/* Output statistics */
+typedef struct {
+    uint32_t    frames_shown;   // Frames transmitted
+    uint32_t    frames_skipped; // Refresh slots skipped because nothing changed
+} serial_stats_t;
+
 class SerialDriver {
  public:
+    serial_stats_t  stats;      // Statistics tracker
+
     int begin(HardwareSerial *theSerial, SerialType type, uint16_t length);
     int begin(HardwareSerial *theSerial, SerialType type, uint16_t length,
             BaudRate baud);
@@ -71,28 +83,40 @@ class SerialDriver {
     inline void setValue(uint16_t address, uint8_t value) {
     // Avoid the special characters by rounding
         if (_type == SerialType::RENARD) {
-            switch (value) {
-                case 0x7d:
-                    _serialdata[address + 2] = 0x7c;
-                    break;
-                case 0x7e:
-                case 0x7f:
-                    _serialdata[address + 2] = 0x80;
-                    break;
-                default:
-                    _serialdata[address + 2] = value;
-                    break;
-            }
+            _serialdata[address + 2] = RENARD_LUT[value];
         } else if (_type == SerialType::DMX512) {
             _serialdata[address + 1] = value;
         }
+        _frameGen++;
     }
 
+    /* Copy a whole frame in from channel 0 */
+    void setData(const uint8_t *data, uint16_t length);
+
     /* Drop the update if our refresh rate is too high */
     inline bool canRefresh() {
         return (micros() - startTime) >= frameTime;
     }
 
+    /* Flag the frame as changed after writing to it through getData() */
+    inline void markDirty() {
+        _frameGen++;
+    }
+
+    /* Has the frame changed since it was last shown */
+    inline bool isDirty() {
+        return _frameGen != _shownGen;
+    }
+
+    /* Give up this refresh slot, the frame hasn't changed. Counted once a frame time */
+    inline void skip() {
+        uint32_t now = micros();
+        if (now - skipTime >= frameTime) {
+            skipTime = now;
+            stats.frames_skipped++;
+        }
+    }
+
  private:
     SerialType      _type;          // Output Serial type
     HardwareSerial  *_serial;       // The Serial Port
@@ -101,6 +125,9 @@ class SerialDriver {
     uint8_t         *_asyncdata;    // Async buffer
     uint32_t        frameTime;      // Time it takes for a frame TX to complete
     uint32_t        startTime;      // When the last frame TX started
+    uint32_t        skipTime;       // When a refresh slot was last counted as skipped
+    uint32_t        _frameGen;      // Frame generation, bumped on every write
+    uint32_t        _shownGen;      // Frame generation at the last show()
 
 
     /* Fill the FIFO */
@@ -108,16 +135,6 @@ class SerialDriver {
 
     /* Serial interrupt handler */
     static void ICACHE_RAM_ATTR serial_handle(void *param);
-
-    /* Returns number of bytes waiting in the TX FIFO of SEROUT_UART */
-    static inline uint8_t getFifoLength() {
-        return (ESP8266_REG(U0F+(0xF00*SEROUT_UART)) >> USTXC) & 0xff;
-    }
-
-    /* Append a byte to the TX FIFO of SEROUT_UART */
-    static inline void enqueue(uint8_t byte) {
-        ESP8266_REG(U0F+(0xF00*SEROUT_UART)) = byte;
-    }
 };
 
 #endif /* SERIALDRIVER_H_ */
@@ -0,0 +1,200 @@
+/*
+* SourceTable.cpp - E1.31 source arbitration for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include "SourceTable.h"
+
+/* Highest takes precedence, in place */
+static inline void mergeHTP(uint8_t *out, const uint8_t *in, uint16_t len) {
+    while (len--) {
+        if (*in > *out)
+            *out = *in;
+        out++;
+        in++;
+    }
+}
+
+bool SourceTable::begin(uint16_t size, uint8_t universes, bool merge) {
+    bool retval = true;
+
+    for (uint8_t i = 0; i < SOURCE_MAX; i++) {
+        if (source[i].data) free(source[i].data);
+    }
+    memset(source, 0, sizeof(source));
+    memset(&stats, 0, sizeof(stats));
+
+    if (seen) free(seen);
+    if (priority) free(priority);
+    if (sequence) free(sequence);
+    if (owner) free(owner);
+
+    uint16_t cells = SOURCE_MAX * universes;
+    seen = static_cast<uint32_t *>(malloc(cells * sizeof(uint32_t)));
+    priority = static_cast<uint8_t *>(malloc(cells));
+    sequence = static_cast<uint8_t *>(malloc(cells));
+    owner = static_cast<int8_t *>(malloc(universes));
+
+    if (seen && priority && sequence && owner) {
+        memset(seen, 0, cells * sizeof(uint32_t));
+        memset(owner, -1, universes);
+        this->universes = universes;
+    } else {
+        this->universes = 0;
+        retval = false;
+    }
+
+    this->size = size;
+    this->merge = merge;
+
+    return retval;
+}
+
+void SourceTable::release(uint8_t src) {
+    // Keep the HTP buffer, the next source will likely want one too
+    uint8_t *data = source[src].data;
+    memset(&source[src], 0, sizeof(e131_source_t));
+    source[src].data = data;
+
+    for (uint8_t uni = 0; uni < universes; uni++) {
+        seen[idx(src, uni)] = 0;
+        if (owner[uni] == src)
+            owner[uni] = -1;
+    }
+}
+
+int8_t SourceTable::find(const uint8_t *cid, uint32_t now) {
+    for (uint8_t i = 0; i < SOURCE_MAX; i++) {
+        if (source[i].last_seen && !memcmp(source[i].cid, cid, sizeof(source[i].cid)))
+            return i;
+    }
+
+    // New source, take the slot of one that has gone quiet
+    for (uint8_t i = 0; i < SOURCE_MAX; i++) {
+        if (!isActive(i)) {
+            release(i);
+            memcpy(source[i].cid, cid, sizeof(source[i].cid));
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int8_t SourceTable::accept(const e131_packet_t &packet, uint8_t uni, int8_t &seqDiff) {
+    seqDiff = 0;
+    if (uni >= universes)
+        return -1;
+
+    if (packet.options & E131_OPT_PREVIEW) {
+        stats.preview++;
+        return -1;
+    }
+
+    uint32_t now = millis();
+    int8_t src = find(packet.cid, now);
+    if (src < 0) {
+        stats.rejected++;
+        return -1;
+    }
+
+    e131_source_t &s = source[src];
+    uint16_t cell = idx(src, uni);
+    if (!s.packets++) {
+        memcpy(s.name, packet.source_name, SOURCE_NAME_LEN - 1);
+        s.name[SOURCE_NAME_LEN - 1] = 0;
+    }
+    s.last_seen = now;
+    s.priority = packet.priority;
+
+    // Hand the universe straight to whoever is next
+    if (packet.options & E131_OPT_TERMINATED) {
+        stats.terminated++;
+        seen[cell] = 0;
+        if (owner[uni] == src)
+            owner[uni] = -1;
+        return -1;
+    }
+
+    // Sequence is per source, so check it before arbitration. Anything up to
+    // E131_SEQ_WINDOW behind the last packet is stale, further back means
+    // the source restarted.
+    if (seen[cell])
+        seqDiff = static_cast<int8_t>(packet.sequence_number - sequence[cell]);
+    if (seqDiff < 0 && seqDiff >= -E131_SEQ_WINDOW) {
+        s.late++;
+        return -1;
+    }
+    if (seqDiff > 0)
+        s.seq_errors++;
+    sequence[cell] = packet.sequence_number + 1;
+    seen[cell] = now;
+    priority[cell] = packet.priority;
+
+    // Highest priority still sending this universe
+    uint8_t top = 0;
+    for (uint8_t i = 0; i < SOURCE_MAX; i++) {
+        if (onUniverse(i, uni, now) && priority[idx(i, uni)] > top)
+            top = priority[idx(i, uni)];
+    }
+
+    if (packet.priority < top) {
+        s.outranked++;
+        return -1;
+    }
+
+    if (merge && !s.data) {
+        if ((s.data = static_cast<uint8_t *>(malloc(size))))
+            memset(s.data, 0, size);
+    }
+
+    // The first source holds the universe. Without a buffer to merge from
+    // that shuts the others out, with one they are merged into the frames
+    // it paces.
+    int8_t o = owner[uni];
+    if (o >= 0 && o != src && onUniverse(o, uni, now) && priority[idx(o, uni)] == top) {
+        if (!merge || !s.data) {
+            s.outranked++;
+            return -1;
+        }
+    } else {
+        owner[uni] = src;
+    }
+
+    return src;
+}
+
+void SourceTable::write(int8_t src, uint8_t uni, uint8_t *frame,
+        const uint8_t *data, uint16_t dst, uint16_t len) {
+    if (src < 0 || !merge || !source[src].data) {
+        memcpy(frame + dst, data, len);
+        return;
+    }
+
+    memcpy(source[src].data + dst, data, len);
+    memcpy(frame + dst, data, len);
+
+    // Fold in everyone else at the same priority on this universe
+    uint32_t now = millis();
+    uint8_t prio = priority[idx(src, uni)];
+    for (uint8_t i = 0; i < SOURCE_MAX; i++) {
+        if (i != src && source[i].data && onUniverse(i, uni, now) &&
+                priority[idx(i, uni)] == prio)
+            mergeHTP(frame + dst, source[i].data + dst, len);
+    }
+}
@@ -0,0 +1,115 @@
+/*
+* SourceTable.h - E1.31 source arbitration for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef SOURCETABLE_H_
+#define SOURCETABLE_H_
+
+#include "E131Rx.h"
+
+#define SOURCE_MAX          4       /* Sources tracked at once */
+#define SOURCE_TIMEOUT      2500    /* ms before a silent source loses a universe */
+#define SOURCE_NAME_LEN     32      /* Characters of the source name kept for stats */
+
+#define E131_OPT_PREVIEW    0x80    /* Not meant for live output */
+#define E131_OPT_TERMINATED 0x40    /* Source is done with this universe */
+
+/* One sender, keyed on CID */
+typedef struct {
+    uint8_t     cid[16];                    // Component identifier
+    char        name[SOURCE_NAME_LEN];      // Source name, truncated
+    uint8_t     priority;                   // Priority of its last packet
+    uint32_t    packets;                    // Data packets received
+    uint32_t    seq_errors;                 // Sequence gaps across its universes
+    uint32_t    late;                       // Stale packets dropped, inside E131_SEQ_WINDOW
+    uint32_t    outranked;                  // Packets dropped for a higher priority or the owner
+    uint32_t    last_seen;                  // When its last packet arrived, in millis
+    uint8_t     *data;                      // HTP buffer in frame layout, allocated on demand
+} e131_source_t;
+
+/* Source table statistics */
+typedef struct {
+    uint32_t    rejected;       // Packets from new sources with the table full
+    uint32_t    preview;        // Preview packets ignored
+    uint32_t    terminated;     // Stream terminated notices
+} source_stats_t;
+
+/*
+* Tracks up to SOURCE_MAX senders across our universes. For each universe
+* only sources at the highest active priority are used. Of those, the first
+* one holds the universe until it times out or is outranked, unless merging
+* is on, in which case they are combined highest-takes-precedence and the
+* holder only paces the frame. Sequence numbers are tracked per source so
+* a backup console doesn't show up as sequence errors, and packets behind
+* the last one by up to E131_SEQ_WINDOW are dropped so stale data never
+* reaches the frame.
+*/
+class SourceTable {
+ public:
+    source_stats_t  stats;              // Statistics tracker
+    e131_source_t   source[SOURCE_MAX]; // The sources
+
+    bool begin(uint16_t size, uint8_t universes, bool merge);
+
+    /*
+    * Arbitrate a data packet for universe uni. Returns the source to write
+    * it as, or -1 to drop it. seqDiff is how far its sequence number was
+    * from the expected one, negative for late packets.
+    */
+    int8_t accept(const e131_packet_t &packet, uint8_t uni, int8_t &seqDiff);
+
+    /* Write an accepted source's slice of a universe into the frame, src -1 for non E1.31 input */
+    void write(int8_t src, uint8_t uni, uint8_t *frame,
+            const uint8_t *data, uint16_t dst, uint16_t len);
+
+    /*
+    * Whether an accepted source's packets mark universe uni as part of the
+    * frame. Only the holder's do, so merged copies don't look like a new
+    * frame. Always true for non E1.31 input, src -1.
+    */
+    inline bool leads(int8_t src, uint8_t uni) {
+        return src < 0 || owner[uni] == src;
+    }
+
+    /* Source has sent within SOURCE_TIMEOUT */
+    inline bool isActive(uint8_t src) {
+        return source[src].last_seen && (millis() - source[src].last_seen) < SOURCE_TIMEOUT;
+    }
+
+ private:
+    uint16_t    size;           // Frame size, for the HTP buffers
+    uint8_t     universes;      // Number of universes
+    bool        merge;          // HTP merge of equal priority sources
+    uint32_t    *seen;          // [source][uni] when last seen, 0 for not on it
+    uint8_t     *priority;      // [source][uni] priority last sent
+    uint8_t     *sequence;      // [source][uni] next expected sequence number
+    int8_t      *owner;         // [uni] source holding it, pacing frames when merging
+
+    inline uint16_t idx(uint8_t src, uint8_t uni) {
+        return src * universes + uni;
+    }
+
+    inline bool onUniverse(uint8_t src, uint8_t uni, uint32_t now) {
+        return seen[idx(src, uni)] && (now - seen[idx(src, uni)]) < SOURCE_TIMEOUT;
+    }
+
+    int8_t find(const uint8_t *cid, uint32_t now);
+    void release(uint8_t src);
+};
+
+#endif /* SOURCETABLE_H_ */
@@ -0,0 +1,75 @@
+/*
+* SpiHal.h - HSPI register access for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef SPIHAL_H_
+#define SPIHAL_H_
+
+/*
+* HSPI sends up to SPI_CHUNK bytes from its W0-W15 registers per command.
+* SPI.writeBytes() waits out every chunk; these let PixelDriver load one
+* and go back to loop() while it's sent. SPI.begin() has already set the
+* pins, mode and clock.
+*
+* Defining ESPS_HOST swaps the registers for the simulated HSPI in
+* test/host, so the drivers build and run on a PC.
+*/
+
+#if defined(ESPS_HOST)
+#include "HostSim.h"
+#else
+#include <esp8266_peri.h>
+#endif
+
+#define SPI_HAL_INLINE  static inline __attribute__((always_inline))
+#define SPI_CHUNK       64      /* Bytes in the W0-W15 registers */
+
+#if defined(ESPS_HOST)
+
+SPI_HAL_INLINE bool spiBusy() {
+    return simSpiBusy();
+}
+
+SPI_HAL_INLINE void spiWrite(const uint8_t *data, uint8_t len) {
+    simSpiWrite(data, len);
+}
+
+#else
+
+/* Still sending the last chunk */
+SPI_HAL_INLINE bool spiBusy() {
+    return SPI1CMD & SPIBUSY;
+}
+
+/* Send len bytes, up to SPI_CHUNK, from data, which must be 4 byte aligned */
+SPI_HAL_INLINE void spiWrite(const uint8_t *data, uint8_t len) {
+    const uint32_t bits = len * 8 - 1;
+    SPI1U1 = (SPI1U1 & ~(SPIMMOSI << SPILMOSI | SPIMMISO << SPILMISO)) |
+            bits << SPILMOSI | bits << SPILMISO;
+
+    const uint32_t *words = reinterpret_cast<const uint32_t *>(data);
+    volatile uint32_t *fifo = &SPI1W0;
+    for (uint8_t i = 0; i < (len + 3) / 4; i++)
+        fifo[i] = words[i];
+
+    SPI1CMD |= SPIBUSY;
+}
+
+#endif /* ESPS_HOST */
+
+#endif /* SPIHAL_H_ */
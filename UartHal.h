@@ -0,0 +1,190 @@
+/*
+* UartHal.h - UART register access for the ESPixelStick output drivers
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef UARTHAL_H_
+#define UARTHAL_H_
+
+/*
+* All of the UART register and interrupt pokes the output drivers need, so
+* PixelDriver and SerialDriver only deal in UART numbers. Everything here is
+* forced inline as most of it is called from the FIFO interrupt handlers.
+*
+* Defining ESPS_HOST swaps the registers for the simulated UARTs in
+* test/host, so the drivers build and run on a PC.
+*/
+
+#if defined(ESPS_HOST)
+#include "HostSim.h"
+#else
+extern "C" {
+#include <eagle_soc.h>
+#include <ets_sys.h>
+#include <uart.h>
+#include <uart_register.h>
+}
+#endif
+
+#define UART_HAL_INLINE static inline __attribute__((always_inline))
+#define UART_INV_MASK   (0x3f << 19)
+
+#if defined(ESPS_HOST)
+
+UART_HAL_INLINE uint8_t uartTxFifoLength(uint8_t uart) {
+    return simUart[uart].count;
+}
+
+UART_HAL_INLINE uint8_t uartTxFifoFree(uint8_t uart) {
+    return UART_TX_FIFO_SIZE - uartTxFifoLength(uart);
+}
+
+UART_HAL_INLINE void uartWrite(uint8_t uart, uint8_t byte) {
+    simUartWrite(uart, byte);
+}
+
+UART_HAL_INLINE void uartConfig(uint8_t uart, uint32_t baud, uint32_t config) {
+    simUartConfig(uart, baud, config);
+}
+
+UART_HAL_INLINE void uartSetBreak(uint8_t uart, bool enable) {
+    simUartBreak(uart, enable);
+}
+
+UART_HAL_INLINE void uartInvertTx(uint8_t uart) {
+    simUartInvert(uart, true);
+}
+
+UART_HAL_INLINE void uartResetFifos(uint8_t uart) {
+    simUartResetFifo(uart);
+}
+
+UART_HAL_INLINE void uartSetTxThreshold(uint8_t uart, uint8_t threshold) {
+    simUart[uart].threshold = threshold;
+}
+
+UART_HAL_INLINE void uartTxIntEnable(uint8_t uart) {
+    simUart[uart].txInt = true;
+}
+
+UART_HAL_INLINE void uartTxIntDisable(uint8_t uart) {
+    simUart[uart].txInt = false;
+}
+
+UART_HAL_INLINE void uartIntDisableAll(uint8_t uart) {
+    simUart[uart].txInt = false;
+}
+
+UART_HAL_INLINE bool uartIntPending(uint8_t uart) {
+    return simUartPending(uart);
+}
+
+/* Pending is level triggered in the simulation, nothing to clear */
+UART_HAL_INLINE void uartIntClear(uint8_t uart) {
+}
+
+UART_HAL_INLINE void uartAttachIsr(void (*handler)(void *)) {
+    simUartIsrEnable(false);
+    simUartAttach(handler);
+}
+
+UART_HAL_INLINE void uartIsrEnable() {
+    simUartIsrEnable(true);
+}
+
+#else
+
+/* Bytes waiting in the TX FIFO */
+UART_HAL_INLINE uint8_t uartTxFifoLength(uint8_t uart) {
+    return (USS(uart) >> USTXC) & 0xff;
+}
+
+/* Bytes that can be written to the TX FIFO right now */
+UART_HAL_INLINE uint8_t uartTxFifoFree(uint8_t uart) {
+    return UART_TX_FIFO_SIZE - uartTxFifoLength(uart);
+}
+
+/* Append a byte to the TX FIFO */
+UART_HAL_INLINE void uartWrite(uint8_t uart, uint8_t byte) {
+    USF(uart) = byte;
+}
+
+/* Baud rate and frame format, for a UART HardwareSerial doesn't own */
+UART_HAL_INLINE void uartConfig(uint8_t uart, uint32_t baud, uint32_t config) {
+    USD(uart) = ESP8266_CLOCK / baud;
+    USC0(uart) = config;
+}
+
+/* Hold TX in break (true) or release it (false) */
+UART_HAL_INLINE void uartSetBreak(uint8_t uart, bool enable) {
+    if (enable)
+        SET_PERI_REG_MASK(UART_CONF0(uart), UART_TXD_BRK);
+    else
+        CLEAR_PERI_REG_MASK(UART_CONF0(uart), UART_TXD_BRK);
+}
+
+/* Invert the TX line only */
+UART_HAL_INLINE void uartInvertTx(uint8_t uart) {
+    CLEAR_PERI_REG_MASK(UART_CONF0(uart), UART_INV_MASK);
+    SET_PERI_REG_MASK(UART_CONF0(uart), (BIT(22)));
+}
+
+/* Flush both FIFOs */
+UART_HAL_INLINE void uartResetFifos(uint8_t uart) {
+    SET_PERI_REG_MASK(UART_CONF0(uart), UART_RXFIFO_RST | UART_TXFIFO_RST);
+    CLEAR_PERI_REG_MASK(UART_CONF0(uart), UART_RXFIFO_RST | UART_TXFIFO_RST);
+}
+
+/* TX empty interrupt fires when the FIFO drops below threshold bytes */
+UART_HAL_INLINE void uartSetTxThreshold(uint8_t uart, uint8_t threshold) {
+    WRITE_PERI_REG(UART_CONF1(uart), threshold << UART_TXFIFO_EMPTY_THRHD_S);
+}
+
+UART_HAL_INLINE void uartTxIntEnable(uint8_t uart) {
+    SET_PERI_REG_MASK(UART_INT_ENA(uart), UART_TXFIFO_EMPTY_INT_ENA);
+}
+
+UART_HAL_INLINE void uartTxIntDisable(uint8_t uart) {
+    CLEAR_PERI_REG_MASK(UART_INT_ENA(uart), UART_TXFIFO_EMPTY_INT_ENA);
+}
+
+/* Turn off the RX and TX interrupts uart.c enables */
+UART_HAL_INLINE void uartIntDisableAll(uint8_t uart) {
+    CLEAR_PERI_REG_MASK(UART_INT_ENA(uart), UART_RXFIFO_FULL_INT_ENA | UART_TXFIFO_EMPTY_INT_ENA);
+}
+
+UART_HAL_INLINE bool uartIntPending(uint8_t uart) {
+    return READ_PERI_REG(UART_INT_ST(uart));
+}
+
+UART_HAL_INLINE void uartIntClear(uint8_t uart) {
+    WRITE_PERI_REG(UART_INT_CLR(uart), 0xffff);
+}
+
+/* Both UARTs share one interrupt, attach handler with it masked */
+UART_HAL_INLINE void uartAttachIsr(void (*handler)(void *)) {
+    ETS_UART_INTR_DISABLE();
+    ETS_UART_INTR_ATTACH(handler, NULL);
+}
+
+UART_HAL_INLINE void uartIsrEnable() {
+    ETS_UART_INTR_ENABLE();
+}
+
+#endif /* ESPS_HOST */
+
+#endif /* UARTHAL_H_ */
@@ -0,0 +1,130 @@
+/*
+* UniverseMap.cpp - Universe to frame channel mapping for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include <algorithm>
+#include "UniverseMap.h"
+
+uint8_t UniverseMap::begin(const patch_t *patch, uint8_t count, uint16_t first, uint8_t universes) {
+    count = std::min(count, static_cast<uint8_t>(PATCH_MAX));
+    if (!alloc(count * 2, universes))
+        return 0;
+
+    // Everywhere a patch starts or stops on the output, in order
+    uint32_t edge[PATCH_MAX * 2];
+    uint8_t edges = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        edge[edges++] = patch[i].offset;
+        edge[edges++] = patch[i].offset + patch[i].length;
+    }
+    std::sort(edge, edge + edges);
+    edges = std::unique(edge, edge + edges) - edge;
+
+    // Between two edges the last patch covering them wins
+    uni_slice_t piece[PATCH_MAX * 2];
+    uint8_t owner[PATCH_MAX * 2];
+    uint8_t pieces = 0;
+    for (uint8_t e = 0; e + 1 < edges; e++) {
+        int8_t win = -1;
+        for (int8_t i = count - 1; i >= 0; i--) {
+            if (patch[i].offset <= edge[e] && edge[e] < patch[i].offset + patch[i].length) {
+                win = i;
+                break;
+            }
+        }
+        if (win < 0)
+            continue;
+
+        // Runs on from the piece before it when it's the same patch
+        uint16_t len = edge[e + 1] - edge[e];
+        if (pieces && owner[pieces - 1] == win &&
+                piece[pieces - 1].dst + piece[pieces - 1].len == edge[e]) {
+            piece[pieces - 1].len += len;
+            continue;
+        }
+        piece[pieces].src = patch[win].channel - 1 + edge[e] - patch[win].offset;
+        piece[pieces].dst = edge[e];
+        piece[pieces].len = len;
+        owner[pieces++] = win;
+    }
+
+    // Count each universe's slices, then turn the counts into run starts
+    for (uint8_t p = 0; p < pieces; p++)
+        idx[patch[owner[p]].universe - first + 1]++;
+    for (uint8_t u = 0; u < universes; u++)
+        idx[u + 1] += idx[u];
+
+    // Fill each run, which leaves every start pointing at the next run
+    for (uint8_t p = 0; p < pieces; p++)
+        slice[idx[patch[owner[p]].universe - first]++] = piece[p];
+    for (uint8_t u = universes; u > 0; u--)
+        idx[u] = idx[u - 1];
+    idx[0] = 0;
+
+    return mapped();
+}
+
+uint8_t UniverseMap::begin(uint16_t start, uint16_t limit, uint16_t size, uint8_t universes) {
+    if (!alloc(universes, universes))
+        return 0;
+
+    int32_t offset = start - 1;
+    uint16_t n = 0;
+    for (uint8_t i = 0; i < universes; i++) {
+        int32_t from = static_cast<int32_t>(i) * limit - offset;
+        int32_t stop = std::min(from + limit, static_cast<int32_t>(size));
+        int32_t dst = std::max(from, static_cast<int32_t>(0));
+
+        if (stop > dst) {
+            slice[n].dst = dst;
+            slice[n].src = dst - from;
+            slice[n].len = stop - dst;
+            n++;
+        }
+        idx[i + 1] = n;
+    }
+
+    return mapped();
+}
+
+bool UniverseMap::alloc(uint16_t count, uint8_t universes) {
+    if (slice) free(slice);
+    if (idx) free(idx);
+    slice = static_cast<uni_slice_t *>(malloc(std::max(count, static_cast<uint16_t>(1)) * sizeof(uni_slice_t)));
+    idx = static_cast<uint16_t *>(calloc(universes + 1, sizeof(uint16_t)));
+    if (!slice || !idx) {
+        free(slice);
+        free(idx);
+        slice = NULL;
+        idx = NULL;
+        this->universes = 0;
+        return false;
+    }
+    this->universes = universes;
+    return true;
+}
+
+uint8_t UniverseMap::mapped() {
+    uint8_t count = 0;
+    for (uint8_t u = 0; u < universes; u++) {
+        if (idx[u] != idx[u + 1])
+            count++;
+    }
+    return count;
+}
@@ -0,0 +1,83 @@
+/*
+* UniverseMap.h - Universe to frame channel mapping for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef UNIVERSEMAP_H_
+#define UNIVERSEMAP_H_
+
+#define PATCH_MAX       32      /* Entries in the channel patch table */
+#define PATCH_UNIVERSES 64      /* Universes a patch table may span, counting from Universe */
+
+/* Channel patch, copies length channels of a universe onto the output */
+typedef struct {
+    uint16_t    universe;   /* Universe to take them from */
+    uint16_t    channel;    /* First channel in the universe - 1 based */
+    uint16_t    offset;     /* Output channel they land on - 0 based */
+    uint16_t    length;     /* Number of channels */
+} patch_t;
+
+/* Where part of a universe lands in the frame */
+typedef struct {
+    uint16_t    src;        /* First channel used from the universe */
+    uint16_t    dst;        /* Frame channel it lands on */
+    uint16_t    len;        /* Channels to copy */
+} uni_slice_t;
+
+/*
+* Compiled once per config so packets don't work out their place in the
+* frame. Slices are grouped by universe, and no two write the same frame
+* channel: where patches overlap the later one in the table wins, whichever
+* universe arrives last. A patch split around a later one becomes a slice
+* either side, so there are at most 2 * PATCH_MAX.
+*/
+class UniverseMap {
+ public:
+    /*
+    * Map universes from the patch table, whose entries have been checked
+    * against the window and frame. Returns the number of universes mapped.
+    */
+    uint8_t begin(const patch_t *patch, uint8_t count, uint16_t first, uint8_t universes);
+
+    /*
+    * Map universes back to back from channel start (1 based), limit
+    * channels each, onto a frame of size channels. limit has been checked
+    * against UNIVERSE_MAX. Returns the number of universes mapped.
+    */
+    uint8_t begin(uint16_t start, uint16_t limit, uint16_t size, uint8_t universes);
+
+    /* Universe uni lands somewhere in the frame */
+    inline bool isMapped(uint8_t uni) {
+        return idx && uni < universes && idx[uni] != idx[uni + 1];
+    }
+
+    /* Universe uni's slices, count of them, in frame order */
+    inline const uni_slice_t *slices(uint8_t uni, uint16_t &count) {
+        count = idx[uni + 1] - idx[uni];
+        return slice + idx[uni];
+    }
+
+ private:
+    uni_slice_t *slice;         // Frame mapping, grouped by universe
+    uint16_t    *idx;           // First slice of each universe, one past the end last
+    uint8_t     universes;      // Number of universes
+
+    bool alloc(uint16_t count, uint8_t universes);
+    uint8_t mapped();
+};
+
+#endif /* UNIVERSEMAP_H_ */
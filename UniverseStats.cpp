@@ -0,0 +1,122 @@
+/*
+* UniverseStats.cpp - Per universe input statistics for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include "E131Rx.h"
+#include "UniverseStats.h"
+
+/* Bucket upper edges in ms, sized around the usual 25ms - 50ms frame times */
+static const uint16_t ARRIVAL_EDGES[STATS_BUCKETS - 1] = { 5, 10, 20, 30, 40, 50, 100 };
+static const uint16_t LATENCY_EDGES[STATS_BUCKETS - 1] = { 1, 2, 5, 10, 20, 30, 50 };
+
+bool UniverseStats::begin(uint8_t universes) {
+    bool retval = true;
+
+    if (uni) free(uni);
+    if (last) free(last);
+    uni = static_cast<uni_stats_t *>(malloc(universes * sizeof(uni_stats_t)));
+    last = static_cast<uint32_t *>(malloc(universes * sizeof(uint32_t)));
+
+    if (uni && last) {
+        memset(uni, 0, universes * sizeof(uni_stats_t));
+        memset(last, 0, universes * sizeof(uint32_t));
+        this->universes = universes;
+    } else {
+        this->universes = 0;
+        retval = false;
+    }
+
+    memset(latency, 0, sizeof(latency));
+    latchStamp = 0;
+
+    return retval;
+}
+
+uint8_t UniverseStats::bucket(const uint16_t *edges, uint32_t us) {
+    uint32_t ms = us / 1000;
+    uint8_t i = 0;
+    while (i < STATS_BUCKETS - 1 && ms >= edges[i])
+        i++;
+    return i;
+}
+
+void UniverseStats::packet(uint8_t u, int8_t seqDiff, uint32_t stamp) {
+    if (u >= universes)
+        return;
+
+    uni_stats_t &s = uni[u];
+    s.received++;
+    if (seqDiff > 0)
+        s.lost += seqDiff;
+
+    if (last[u])
+        s.arrival[bucket(ARRIVAL_EDGES, stamp - last[u])]++;
+    last[u] = stamp;
+}
+
+void UniverseStats::dropped(uint8_t u, int8_t seqDiff) {
+    if (u >= universes)
+        return;
+
+    uni_stats_t &s = uni[u];
+    if (seqDiff == -1)
+        s.duplicate++;
+    else if (seqDiff < -1 && seqDiff >= -E131_SEQ_WINDOW)
+        s.out_of_order++;
+    else
+        s.rejected++;
+}
+
+void UniverseStats::latched(uint32_t stamp) {
+    latchStamp = stamp;
+}
+
+void UniverseStats::shown() {
+    if (latchStamp) {
+        latency[bucket(LATENCY_EDGES, micros() - latchStamp)]++;
+        latchStamp = 0;
+    }
+}
+
+uint32_t UniverseStats::seqErrors() {
+    uint32_t errors = 0;
+    for (uint8_t u = 0; u < universes; u++)
+        errors += uni[u].lost + uni[u].out_of_order + uni[u].duplicate;
+    return errors;
+}
+
+void UniverseStats::serialize(uint8_t *buf, uint16_t firstUniverse) {
+    buf[0] = 'X';
+    buf[1] = 'S';
+    buf[2] = STATS_VERSION;
+    buf[3] = STATS_BUCKETS;
+    buf[4] = universes;
+    buf[5] = 0;
+    buf[6] = firstUniverse & 0xff;
+    buf[7] = firstUniverse >> 8;
+    buf += 8;
+
+    memcpy(buf, ARRIVAL_EDGES, sizeof(ARRIVAL_EDGES));
+    buf += sizeof(ARRIVAL_EDGES);
+    memcpy(buf, LATENCY_EDGES, sizeof(LATENCY_EDGES));
+    buf += sizeof(LATENCY_EDGES);
+    memcpy(buf, latency, sizeof(latency));
+    buf += sizeof(latency);
+    memcpy(buf, uni, universes * sizeof(uni_stats_t));
+}
@@ -0,0 +1,83 @@
+/*
+* UniverseStats.h - Per universe input statistics for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef UNIVERSESTATS_H_
+#define UNIVERSESTATS_H_
+
+#define STATS_BUCKETS   8       /* Histogram buckets, the last one is open ended */
+#define STATS_VERSION   2       /* Binary stats message layout */
+
+/* Counters for one universe */
+typedef struct {
+    uint32_t    received;               // Packets accepted into the frame
+    uint32_t    lost;                   // Packets missing from sequence gaps
+    uint32_t    out_of_order;           // Stale packets dropped, older than one already received
+    uint32_t    duplicate;              // Packets repeating the last sequence number, dropped
+    uint32_t    rejected;               // Packets dropped by arbitration, preview or termination
+    uint32_t    arrival[STATS_BUCKETS]; // Inter-arrival time histogram
+} uni_stats_t;
+
+/*
+* Binary stats message, all little endian:
+*   'X' 'S' version buckets universes 0 first_universe(16)
+*   arrival edges, latency edges    uint16[buckets - 1] each, in ms
+*   latency histogram               uint32[buckets]
+*   per universe                    received lost out_of_order duplicate rejected
+*                                   arrival histogram uint32[buckets]
+* Bucket n counts values below edge n and at least edge n - 1.
+*/
+class UniverseStats {
+ public:
+    uni_stats_t     *uni;                       // Counters for each universe
+    uint32_t        latency[STATS_BUCKETS];     // Packet to show latency histogram
+
+    bool begin(uint8_t universes);
+
+    /* Packet for universe uni was accepted at stamp micros, seqDiff from its expected sequence */
+    void packet(uint8_t uni, int8_t seqDiff, uint32_t stamp);
+
+    /* Packet for universe uni was dropped, seqDiff as for packet() */
+    void dropped(uint8_t uni, int8_t seqDiff);
+
+    /* A frame was latched by the packet that arrived at stamp micros, 0 for none */
+    void latched(uint32_t stamp);
+
+    /* The latched frame started going out */
+    void shown();
+
+    /* All sequence gaps and stale packets across universes */
+    uint32_t seqErrors();
+
+    /* Size of the binary message */
+    inline size_t size() {
+        return 8 + (STATS_BUCKETS - 1) * 4 + STATS_BUCKETS * 4 + universes * sizeof(uni_stats_t);
+    }
+
+    /* Write the binary message to buf, which must hold size() bytes */
+    void serialize(uint8_t *buf, uint16_t firstUniverse);
+
+ private:
+    uint8_t     universes;      // Number of universes
+    uint32_t    *last;          // When each universe was last seen, micros
+    uint32_t    latchStamp;     // Arrival of the packet that latched the pending frame
+
+    static uint8_t bucket(const uint16_t *edges, uint32_t us);
+};
+
+#endif /* UNIVERSESTATS_H_ */
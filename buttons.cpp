@@ -20,6 +20,7 @@ extern  config_t        config;
 //extern  testing_t       testing;
 extern  EffectEngine        effects;    // Effects Engine
 extern  uint32_t        pwm_valid_gpio_mask;
+extern  uint32_t        pwm_reserved_gpio_mask;
 
 int done_setup = 0;
 
@@ -35,8 +36,8 @@ int selected_option = 0;
 #define BUTTON_MAX 50
 
 // globals to hold current colour
-rgb global_rgb;
-hsv global_hsv;
+CRGB global_rgb;
+CHSV global_hsv;
 
 unsigned long last_millis;
 
@@ -54,7 +55,8 @@ void setupButtons() {
   pinMode(BUTTON, INPUT_PULLUP);
   pinMode(ROTARY_A, INPUT_PULLUP);
   pinMode(ROTARY_B, INPUT_PULLUP);
-  pwm_valid_gpio_mask &= ~( 1<<BUTTON | 1<<ROTARY_A | 1<<ROTARY_B );
+  pwm_reserved_gpio_mask |= ( 1<<BUTTON | 1<<ROTARY_A | 1<<ROTARY_B );
+  pwm_valid_gpio_mask &= ~pwm_reserved_gpio_mask;
 }
 
 void handleButtons() {
@@ -67,7 +69,7 @@ void handleButtons() {
     debounce_buttons();
     handle_rotary_encoder();
     if (button_mode >= 1) {
-      set_testing_led( global_rgb.r*255, global_rgb.g*255, global_rgb.b*255 );
+      set_testing_led( global_rgb.r, global_rgb.g, global_rgb.b );
       do_button_animations();
     }
   }
@@ -200,28 +202,28 @@ void update_rgbhsv_from_pos() {
       int combo = (button_mode-1)*3 + selected_option;
       switch (combo) {
         case 0: // Red
-          global_rgb.r = (double) rotary_pos / ROT_MAX;
+          global_rgb.r = 255 * rotary_pos / ROT_MAX;
           global_hsv = rgb2hsv(global_rgb);
           break;
         case 1: // Green
-          global_rgb.g = (double) rotary_pos / ROT_MAX;
+          global_rgb.g = 255 * rotary_pos / ROT_MAX;
           global_hsv = rgb2hsv(global_rgb);
           break;
         case 2: // Blue
-          global_rgb.b = (double) rotary_pos / ROT_MAX;
+          global_rgb.b = 255 * rotary_pos / ROT_MAX;
           global_hsv = rgb2hsv(global_rgb);
           break;
 
         case 3: // Hue
-          global_hsv.h = (double) 360 * rotary_pos / ROT_MAX;
+          global_hsv.h = 65536UL * rotary_pos / ROT_MAX;   // a full turn wraps to 0
           global_rgb = hsv2rgb(global_hsv);
           break;
         case 4: // Saturation
-          global_hsv.s = (double) rotary_pos / ROT_MAX;
+          global_hsv.s = 255 * rotary_pos / ROT_MAX;
           global_rgb = hsv2rgb(global_hsv);
           break;
         case 5: // Value
-          global_hsv.v = (double) rotary_pos / ROT_MAX;
+          global_hsv.v = 255 * rotary_pos / ROT_MAX;
           global_rgb = hsv2rgb(global_hsv);
           break;
       }
@@ -235,22 +237,22 @@ void update_pos_from_rgbhsv() {
 
         switch (combo) {
           case 0: // Red
-            rotary_pos = global_rgb.r * ROT_MAX;
+            rotary_pos = (global_rgb.r * ROT_MAX + 127) / 255;
             break;
           case 1: // Green
-            rotary_pos = global_rgb.g * ROT_MAX;
+            rotary_pos = (global_rgb.g * ROT_MAX + 127) / 255;
             break;
           case 2: // Blue
-            rotary_pos = global_rgb.b * ROT_MAX;
+            rotary_pos = (global_rgb.b * ROT_MAX + 127) / 255;
             break;
           case 3: // Hue
-            rotary_pos = global_hsv.h * ROT_MAX / 360;
+            rotary_pos = ((uint32_t)global_hsv.h * ROT_MAX + 32768) >> 16;
             break;
           case 4: // Saturation
-            rotary_pos = global_hsv.s * ROT_MAX;
+            rotary_pos = (global_hsv.s * ROT_MAX + 127) / 255;
             break;
           case 5: // Value
-            rotary_pos = global_hsv.v * ROT_MAX;
+            rotary_pos = (global_hsv.v * ROT_MAX + 127) / 255;
             break;
         }
         encoder.setPosition(rotary_pos);
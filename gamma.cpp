@@ -1,10 +1,25 @@
 #include <Arduino.h>
+#include "Mode.h"
+#include "gamma.h"
+
+#if defined(ESPS_MODE_PIXEL)
+#include "PixelDriver.h"
+#endif
 
 uint16_t GAMMA_TABLE[256] = { 0 };
+uint32_t GAMMA_2811[256] = { 0 };
 
-void updateGammaTable(float gammaVal, float briteVal) {
+void updateGammaTable(float gammaVal, float briteVal, bool dither) {
   for (int i=0; i<256; i++) {
     GAMMA_TABLE[i] = (uint16_t) min((65535.0 * pow(i * briteVal /255.0, gammaVal) + 0.5), 65535.0);
+
+#if defined(ESPS_MODE_PIXEL)
+    // Pre-encode the UART symbols so the ISR does a single load per subpixel
+    uint8_t val = dither ? i : GAMMA_TABLE[i] >> GAMMA_SHIFT;
+    GAMMA_2811[i] = static_cast<uint32_t>(LOOKUP_2811[(val >> 6) & 0x3]) |
+                    static_cast<uint32_t>(LOOKUP_2811[(val >> 4) & 0x3]) << 8 |
+                    static_cast<uint32_t>(LOOKUP_2811[(val >> 2) & 0x3]) << 16 |
+                    static_cast<uint32_t>(LOOKUP_2811[(val >> 0) & 0x3]) << 24;
+#endif
   }
 }
-
@@ -4,8 +4,14 @@
 /* Gamma correction table */
 extern uint16_t GAMMA_TABLE[];
 
+/*
+* Gamma corrected WS2811 UART symbols - 4 bytes per subpixel, first out in LSB.
+* Linear when dithering, PixelDriver applies GAMMA_TABLE itself then.
+*/
+extern uint32_t GAMMA_2811[];
+
 #define GAMMA_SHIFT 8
 
-void updateGammaTable(float gammaVal, float briteVal);
+void updateGammaTable(float gammaVal, float briteVal, bool dither = false);
 
 #endif /* GAMMA_H_ */
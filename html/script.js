@@ -242,6 +242,12 @@ $(function() {
             $('#p_color').prop('disabled', false);
             $('#o_gamma').removeClass('hidden');
         }
+
+        if ($('select[name=p_type]').val() == '2') {
+            $('#o_spi').removeClass('hidden');
+        } else {
+            $('#o_spi').addClass('hidden');
+        }
     });
 
     // Serial protocol toggles
@@ -391,6 +397,7 @@ function wifiValidation() {
 function feed() {
     if ($('#home').is(':visible')) {
         wsEnqueue('XJ');
+        wsEnqueue('XS');
 
         setTimeout(function() {
             feed();
@@ -424,6 +431,7 @@ function wsConnect() {
             wsEnqueue('G2'); // Get Net Status
             wsEnqueue('G3'); // Get Effect Info
             wsEnqueue('G4'); // Get Gamma Table
+            wsEnqueue('G5'); // Get Effect Program
 
             feed();
         };
@@ -448,6 +456,9 @@ function wsConnect() {
                 case 'G4':
                     refreshGamma(data);
                     break;
+                case 'G5':
+                    $('#t_program').val(data);
+                    break;
                 case 'S1':
                     setConfig(data);
                     reboot();
@@ -460,6 +471,9 @@ function wsConnect() {
                     break;
                 case 'S4':
                     break;
+                case 'S5':
+                    programResult(data);
+                    break;
                 case 'XJ':
                     getJsonStatus(data);
                     break;
@@ -473,9 +487,19 @@ function wsConnect() {
                     break;
                 }
             } else {
-                streamData= new Uint8Array(event.data);
-                drawStream(streamData);
-                if ($('#diag').is(':visible')) wsEnqueue('V1');
+                switch (binaryTag(new Uint8Array(event.data))) {
+                case 'XS':
+                    getBinaryStats(new DataView(event.data));
+                    break;
+                case 'V1':
+                    streamData= new Uint8Array(event.data, 2);
+                    drawStream(streamData);
+                    if ($('#diag').is(':visible')) wsEnqueue('V1');
+                    break;
+                default:
+                    console.log('Unknown binary message');
+                    break;
+                }
             }
             wsReadyToSend();
         };
@@ -650,19 +674,28 @@ function getConfig(data) {
     $('#universe_limit').val(config.e131.universe_limit);
     $('#channel_start').val(config.e131.channel_start);
     $('#multicast').prop('checked', config.e131.multicast);
+    $('#e131_merge').prop('checked', config.e131.merge);
+    $('#artnet').prop('checked', config.e131.artnet);
+    $('#ddp').prop('checked', config.e131.ddp);
+    $('#patch').val($.map(config.e131.patch || [], function(p) {
+        return p.join(', ');
+    }).join('\n'));
 
     // Output Config
     $('.odiv').addClass('hidden');
     if (config.device.mode & 0x01) {  // Pixel
         mode = 'pixel';
         $('#o_pixel').removeClass('hidden');
-        $('#p_count').val(config.e131.channel_count / 3);
         $('#p_type').val(config.pixel.type);
         $('#p_color').val(config.pixel.color);
+        $('#p_count').val(config.e131.channel_count / pixelChannels());
         $('#p_groupSize').val(config.pixel.groupSize);
         $('#p_zigSize').val(config.pixel.zigSize);
         $('#p_gammaVal').val(config.pixel.gammaVal);
         $('#p_briteVal').val(config.pixel.briteVal);
+        $('#p_dither').prop('checked', config.pixel.dither);
+        $('#p_spiClock').val(config.pixel.spiClock / 1000000);
+        $('#p_spiBright').val(config.pixel.spiBright);
 
 //      if(config.e131.channel_count / 3 <8 ) {
 //          $('#v_columns').val(config.e131.channel_count / 3);
@@ -671,13 +704,14 @@ function getConfig(data) {
 //      } else {
 //          $('#v_columns').val(25);
 //      }
-        $('#v_columns').val(Math.floor(Math.sqrt(config.e131.channel_count/3)));
+        $('#v_columns').val(Math.floor(Math.sqrt(config.e131.channel_count / pixelChannels())));
 
         $("input[name='viewStyle'][value='RGB']").trigger('click');
         clearStream();
 
         // Trigger updated elements
         $('#p_type').trigger('click');
+        $('#p_type').trigger('change');
         $('#p_count').trigger('change');
     }
 
@@ -900,14 +934,72 @@ function getJsonStatus(data) {
     $('#pkts').text(status.e131.num_packets);
     $('#serr').text(status.e131.seq_errors);
     $('#perr').text(status.e131.packet_errors);
+    $('#filtered').text(status.e131.filtered);
+    $('#overruns').text(status.e131.overruns);
     $('#clientip').text(status.e131.last_clientIP);
     $('#e131_lastseen').text(status.e131.last_seen);
     $('#e131_lastseen').text( millsToDateString(status.e131.last_seen, "Never") );
+    $('#frames_complete').text(status.e131.frames_complete);
+    $('#frames_partial').text(status.e131.frames_partial);
+    $('#frames_synced').text(status.e131.frames_synced);
+    $('#sync_packets').text(status.e131.sync_packets);
+    $('#superseded').text(status.e131.superseded);
+
+    var sources = $('#e131_sources').empty();
+    $.each(status.e131.sources, function(i, src) {
+        sources.append($('<div>').text(src.name + ' (' + src.priority + ')' +
+                (src.active ? '' : ' - inactive') + ': ' + src.packets + ' packets, ' +
+                src.seq_errors + ' sequence gaps, ' + src.late + ' late, ' + src.outranked + ' outranked'));
+    });
+
+// getOutputStatus(data)
+    $('#out_shown').text(status.output.frames_shown);
+    $('#out_skipped').text(status.output.frames_skipped);
+    if (typeof status.output.fps !== 'undefined') {
+        $('.pixel_only').removeClass('hidden');
+        $('#out_done').text(status.output.frames_done);
+        $('#out_fps').text(status.output.fps);
+        $('#out_underruns').text(status.output.underruns);
+        $('#out_isr').text(status.output.isr_min + ' / ' + status.output.isr_avg + ' / ' + status.output.isr_max);
+    } else {
+        $('.pixel_only').addClass('hidden');
+    }
 
 // getMQTTStatus(data)
     $('#mqtt_pkts').text(status.mqtt.num_packets);
     $('#mqtt_lastseen').text( millsToDateString(status.mqtt.last_seen, "Never") );
 
+// getArtNetStatus(data)
+    $('#artnet_pkts').text(status.artnet.num_packets);
+    $('#artnet_syncpkts').text(status.artnet.sync_packets);
+    $('#artnet_polls').text(status.artnet.polls);
+    $('#artnet_perr').text(status.artnet.packet_errors);
+    $('#artnet_filtered').text(status.artnet.filtered);
+    $('#artnet_serr').text(status.artnet.seq_errors);
+    $('#artnet_late').text(status.artnet.late);
+    $('#artnet_overruns').text(status.artnet.overruns);
+    $('#artnet_clientip').text(status.artnet.last_clientIP);
+    $('#artnet_lastseen').text( millsToDateString(status.artnet.last_seen, "Never") );
+
+// getDDPStatus(data)
+    $('#ddp_pkts').text(status.ddp.num_packets);
+    $('#ddp_pushpkts').text(status.ddp.push_packets);
+    $('#ddp_serr').text(status.ddp.seq_errors);
+    $('#ddp_perr').text(status.ddp.packet_errors);
+    $('#ddp_overruns').text(status.ddp.overruns);
+    $('#ddp_clientip').text(status.ddp.last_clientIP);
+    $('#ddp_lastseen').text( millsToDateString(status.ddp.last_seen, "Never") );
+
+// getEffectStatus(data)
+    $('#fx_render').text(status.effects.render_us);
+    $('#fx_compose').text(status.effects.compose_us);
+    $('#fx_dropped').text(status.effects.dropped);
+    var layers = $('#fx_layers').empty();
+    $.each(status.effects.layers, function(i, layer) {
+        layers.append($('<div>').text(layer.index + ': ' + layer.effect + ' (' + layer.blend + ', ' +
+                layer.opacity + ') ' + layer.render_us + ' us, ' + layer.dropped + ' dropped'));
+    });
+
 // getUDPStatus(data)
     $('#udp_pkts').text(status.udp.num_packets);
     $('#udp_shortpkts').text(status.udp.short_packets);
@@ -972,7 +1064,7 @@ function submitWiFi() {
 function submitConfig() {
     var channels = parseInt($('#s_count').val());
     if (mode == 'pixel')
-        channels = parseInt($('#p_count').val()) * 3;
+        channels = parseInt($('#p_count').val()) * pixelChannels();
 
     var json = {
             'device': {
@@ -994,7 +1086,11 @@ function submitConfig() {
                 'universe_limit': parseInt($('#universe_limit').val()),
                 'channel_start': parseInt($('#channel_start').val()),
                 'channel_count': channels,
-                'multicast': $('#multicast').prop('checked')
+                'multicast': $('#multicast').prop('checked'),
+                'merge': $('#e131_merge').prop('checked'),
+                'artnet': $('#artnet').prop('checked'),
+                'ddp': $('#ddp').prop('checked'),
+                'patch': parsePatch($('#patch').val())
             },
             'pixel': {
                 'type': parseInt($('#p_type').val()),
@@ -1002,7 +1098,10 @@ function submitConfig() {
                 'groupSize': parseInt($('#p_groupSize').val()),
                 'zigSize': parseInt($('#p_zigSize').val()),
                 'gammaVal': parseFloat($('#p_gammaVal').val()),
-                'briteVal': parseFloat($('#p_briteVal').val())
+                'briteVal': parseFloat($('#p_briteVal').val()),
+                'dither': $('#p_dither').prop('checked'),
+                'spiClock': Math.round(parseFloat($('#p_spiClock').val()) * 1000000),
+                'spiBright': parseInt($('#p_spiBright').val())
             },
             'serial': {
                 'type': parseInt($('#s_proto').val()),
@@ -1063,6 +1162,12 @@ function submitStartupEffect() {
     wsEnqueue('S3' + JSON.stringify(json));
 }
 
+// Channels per pixel for the selected color order, one per letter
+function pixelChannels() {
+    var order = $('#p_color option:selected').text();
+    return order.length ? order.length : 3;
+}
+
 function refreshPixel() {
     var proto = $('#p_type option:selected').text();
     var size = parseInt($('#p_count').val());
@@ -1070,11 +1175,14 @@ function refreshPixel() {
     var idle = 300;
 
     if (!proto.localeCompare('WS2811 800kHz')) {
-        frame = 30;
+        frame = 10 * pixelChannels();
         idle = 300;
     } else if (!proto.localeCompare('GE Color Effects')) {
         frame = 790;
         idle = 35;
+    } else if (!proto.localeCompare('APA102 / SK9822')) {
+        frame = 32 / parseFloat($('#p_spiClock').val());
+        idle = 0;
     }
 
     var rate = (frame * size + idle) / 1000;
@@ -1191,6 +1299,83 @@ function sendGamma() {
     wsEnqueue('G4'); // Get Gamma Table
 }
 
+function submitProgram() {
+    var json = { 'program': $('#t_program').val() };
+    wsEnqueue('S5' + JSON.stringify(json));
+}
+
+function programResult(data) {
+    var result = JSON.parse(data);
+    if (result.hasOwnProperty('error')) {
+        $('#t_program_status').text(result.error);
+    } else {
+        $('#t_program_status').text('Saved, ' + result.size + ' bytes');
+    }
+}
+
+// Histogram as bars scaled to its largest bucket
+function drawHistogram(counts) {
+    var max = Math.max.apply(null, counts) || 1;
+    var hist = $('<span class="esps-hist">');
+    $.each(counts, function(i, count) {
+        hist.append($('<span>').css('height', Math.round(count * 20 / max) + 'px').attr('title', count));
+    });
+    return hist;
+}
+
+// Binary replies start with their command like the text ones, 'V1' or 'XS'
+function binaryTag(bytes) {
+    return bytes.length >= 2 ? String.fromCharCode(bytes[0], bytes[1]) : '';
+}
+
+// Binary per universe stats, layout in UniverseStats.h
+function getBinaryStats(view) {
+    if (view.byteLength < 8 || view.getUint8(0) != 0x58 || view.getUint8(1) != 0x53 || view.getUint8(2) != 2)
+        return;
+
+    var buckets = view.getUint8(3);
+    var universes = view.getUint8(4);
+    var first = view.getUint16(6, true);
+    var pos = 8;
+
+    function read16(count) {
+        var values = [];
+        for (var i = 0; i < count; i++, pos += 2) values.push(view.getUint16(pos, true));
+        return values;
+    }
+    function read32(count) {
+        var values = [];
+        for (var i = 0; i < count; i++, pos += 4) values.push(view.getUint32(pos, true));
+        return values;
+    }
+
+    $('#arrival_edges').text(read16(buckets - 1).join(' / '));
+    $('#latency_edges').text(read16(buckets - 1).join(' / '));
+    $('#latency_hist').replaceWith(drawHistogram(read32(buckets)).attr('id', 'latency_hist'));
+
+    var body = $('#uni_stats tbody').empty();
+    for (var u = 0; u < universes; u++) {
+        var c = read32(5);
+        var arrival = read32(buckets);
+        var loss = (c[0] + c[1]) ? (c[1] * 100 / (c[0] + c[1])).toFixed(2) + '%' : '-';
+        body.append($('<tr>').append(
+            $('<td>').text(first + u), $('<td>').text(c[0]), $('<td>').text(c[1]),
+            $('<td>').text(c[2]), $('<td>').text(c[3]), $('<td>').text(c[4]), $('<td>').text(loss),
+            $('<td>').append(drawHistogram(arrival))));
+    }
+}
+
+// Patch table lines of "universe, channel, offset, length"
+function parsePatch(text) {
+    var patch = [];
+    $.each(text.split('\n'), function(i, line) {
+        var p = $.map(line.trim().split(/[\s,]+/), function(v) { return parseInt(v); });
+        if (p.length == 4 && p.every(function(v) { return !isNaN(v) && v >= 0; }))
+            patch.push(p);
+    });
+    return patch;
+}
+
 function millsToDateString(millis, stringIfZero) {
 
     if ( (millis > 0) || (stringIfZero.length == 0) ){
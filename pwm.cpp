@@ -9,19 +9,40 @@ extern  config_t    config;         // Current configuration
 uint16_t last_pwm[NUM_GPIO];   // 0-1023, 0=dark
 
 // GPIO 6-11 are for flash chip
-#if defined (ESPS_MODE_PIXEL) || ( defined(ESPS_MODE_SERIAL) && (SEROUT_UART == 1))
+#if defined (ESPS_MODE_PIXEL) && defined(ESPS_ENABLE_DUAL_OUTPUT)
+// { 0,    3,4,5,12,13,14,15,16 };  // 1 and 2 are WS2811 led data
+const uint32_t pwm_default_gpio_mask = 0b11111000000111001;
+
+#elif defined (ESPS_MODE_PIXEL) || ( defined(ESPS_MODE_SERIAL) && (SEROUT_UART == 1))
 // { 0,1,  3,4,5,12,13,14,15,16 };  // 2 is WS2811 led data
-uint32_t pwm_valid_gpio_mask = 0b11111000000111011;
+const uint32_t pwm_default_gpio_mask = 0b11111000000111011;
 
 #elif defined(ESPS_MODE_SERIAL) && (SEROUT_UART == 0)
 // { 0,  2,3,4,5,12,13,14,15,16 };  // 1 is serial TX for DMX data
-uint32_t pwm_valid_gpio_mask = 0b11111000000111101;
+const uint32_t pwm_default_gpio_mask = 0b11111000000111101;
 #endif
 
+// HSPI data, clock and MISO, taken by APA102 output
+#define PWM_HSPI_GPIO_MASK  (1<<12 | 1<<13 | 1<<14)
+
+uint32_t pwm_reserved_gpio_mask = 0;    // Pins other features hold for good, buttons
+uint32_t pwm_valid_gpio_mask = pwm_default_gpio_mask;
+
 
 #if defined(ESPS_SUPPORT_PWM)
+// GECE output is clocked from timer1, which analogWrite() also uses, so PWM
+// sits out while it runs and comes back with the setting as saved
+static bool pwmEnabled() {
+#if defined (ESPS_MODE_PIXEL)
+  if ( config.pixel_type == PixelType::GECE ) {
+    return false;
+  }
+#endif
+  return config.pwm_global_enabled;
+}
+
 void setupPWM () {
-  if ( config.pwm_global_enabled ) {
+  if ( pwmEnabled() ) {
     if ( (config.pwm_freq >= 100) && (config.pwm_freq <= 1000) ) {
       analogWriteFreq(config.pwm_freq);
     }
@@ -35,10 +56,37 @@ void setupPWM () {
   }
 }
 
+// Work out the pins left for PWM from scratch, the pixel type may have changed.
+// Pins that leave stop their waveform, pins that come back are set up again.
+void updatePWMMask() {
+  uint32_t mask = pwm_default_gpio_mask & ~pwm_reserved_gpio_mask;
+#if defined (ESPS_MODE_PIXEL)
+  if ( config.pixel_type == PixelType::APA102 ) {
+    mask &= ~PWM_HSPI_GPIO_MASK;
+  }
+#endif
+
+  uint32_t changed = (mask ^ pwm_valid_gpio_mask) & config.pwm_gpio_enabled;
+  pwm_valid_gpio_mask = mask;
+  if ( !pwmEnabled() ) {
+    return;
+  }
+  for (int gpio=0; gpio < NUM_GPIO; gpio++ ) {
+    if ( changed & 1<<gpio ) {
+      if ( mask & 1<<gpio ) {
+        pinMode(gpio, OUTPUT);
+      } else {
+        analogWrite(gpio, 0);
+      }
+      last_pwm[gpio] = 65535;  // invalid value to force an update when it's back
+    }
+  }
+}
+
 void handlePWM() {
 
   uint16_t pwm_val = 0;
-  if ( config.pwm_global_enabled ) {
+  if ( pwmEnabled() ) {
     for (int gpio=0; gpio < NUM_GPIO; gpio++ ) {
       if ( ( pwm_valid_gpio_mask & 1<<gpio ) && (config.pwm_gpio_enabled & 1<<gpio) ) {
 
@@ -6,6 +6,7 @@
 #define NUM_GPIO 17    // 0 .. 16 inclusive
 
 extern uint32_t pwm_valid_gpio_mask;
+extern uint32_t pwm_reserved_gpio_mask;
 
 #if defined(ESPS_MODE_PIXEL)
 extern PixelDriver     pixels;         // Pixel object
@@ -14,6 +15,7 @@ extern SerialDriver    serial;         // Serial object
 #endif
 
 void setupPWM ();
+void updatePWMMask ();
 void handlePWM ();
 
 #endif // PWM_H_
@@ -1,10 +1,11 @@
 #include <Arduino.h>
 #include "rgbhsv.h"
 
-hsv rgb2hsv(rgb in)
+CHSV rgb2hsv(CRGB in)
 {
-    hsv         out;
-    double      min, max, delta;
+    CHSV        out;
+    uint8_t     min, max, delta;
+    int32_t     h;
 
     min = in.r < in.g ? in.r : in.g;
     min = min  < in.b ? min  : in.b;
@@ -14,93 +15,56 @@ hsv rgb2hsv(rgb in)
 
     out.v = max;                                // v
     delta = max - min;
-    if (delta < 0.00001)
-    {
+    if (!delta) {                               // grey, hue is undefined
         out.s = 0;
-        out.h = 0; // undefined, maybe nan?
+        out.h = 0;
         return out;
     }
-    if( max > 0.0 ) { // NOTE: if Max is == 0, this divide would cause a crash
-        out.s = (delta / max);                  // s
-    } else {
-        // if max is 0, then r = g = b = 0
-        // s = 0, v is undefined
-        out.s = 0.0;
-        out.h = NAN;                            // its now undefined
-        return out;
-    }
-    if( in.r >= max )                           // > is bogus, just keeps compilor happy
-        out.h = ( in.g - in.b ) / delta;        // between yellow & magenta
-    else
-    if( in.g >= max )
-        out.h = 2.0 + ( in.b - in.r ) / delta;  // between cyan & yellow
-    else
-        out.h = 4.0 + ( in.r - in.g ) / delta;  // between magenta & cyan
+    out.s = (delta * 255 + max / 2) / max;      // s, max > 0 as delta is
 
-    out.h *= 60.0;                              // degrees
+    // Sextant plus offset within it, scaled so one turn is 65536
+    if (in.r == max)
+        h = in.g - in.b;                        // between yellow & magenta
+    else if (in.g == max)
+        h = 2 * delta + in.b - in.r;            // between cyan & yellow
+    else
+        h = 4 * delta + in.r - in.g;            // between magenta & cyan
 
-    if( out.h < 0.0 )
-        out.h += 360.0;
+    h = h * 65536 / (6 * delta);
+    out.h = static_cast<uint16_t>(h);           // negative wraps round to red
 
     return out;
 }
 
 
-rgb hsv2rgb(hsv in)
+CRGB hsv2rgb(CHSV in)
 {
-    double      hh, p, q, t, ff;
-    long        i;
-    rgb         out;
+    uint8_t     sextant, f, p, q, t;
+    uint32_t    hh;
 
-    if(in.s <= 0.0) {       // < is bogus, just shuts up warnings
-        out.r = in.v;
-        out.g = in.v;
-        out.b = in.v;
-        return out;
-    }
-    hh = in.h;
-    if(hh >= 360.0) hh = 0.0;
-    hh /= 60.0;
-    i = (long)hh;
-    ff = hh - i;
-    p = in.v * (1.0 - in.s);
-    q = in.v * (1.0 - (in.s * ff));
-    t = in.v * (1.0 - (in.s * (1.0 - ff)));
+    if (!in.s)
+        return { in.v, in.v, in.v };
+
+    hh = static_cast<uint32_t>(in.h) * 6;
+    sextant = hh >> 16;
+    f = (hh >> 8) & 0xff;                       // fraction through the sextant
+    p = scale8(in.v, 255 - in.s);
+    q = scale8(in.v, 255 - scale8(in.s, f));
+    t = scale8(in.v, 255 - scale8(in.s, 255 - f));
 
-    switch(i) {
+    switch (sextant) {
     case 0:
-        out.r = in.v;
-        out.g = t;
-        out.b = p;
-        break;
+        return { in.v, t, p };
     case 1:
-        out.r = q;
-        out.g = in.v;
-        out.b = p;
-        break;
+        return { q, in.v, p };
     case 2:
-        out.r = p;
-        out.g = in.v;
-        out.b = t;
-        break;
-
+        return { p, in.v, t };
     case 3:
-        out.r = p;
-        out.g = q;
-        out.b = in.v;
-        break;
+        return { p, q, in.v };
     case 4:
-        out.r = t;
-        out.g = p;
-        out.b = in.v;
-        break;
+        return { t, p, in.v };
     case 5:
     default:
-        out.r = in.v;
-        out.g = p;
-        out.b = q;
-        break;
+        return { in.v, p, q };
     }
-    return out;
 }
-
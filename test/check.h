@@ -0,0 +1,69 @@
+/*
+* check.h - Minimal assertions for the host tests
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef CHECK_H_
+#define CHECK_H_
+
+#include <stdio.h>
+
+/*
+* CHECK() and CHECK_EQ() report a failure and carry on, RUN() runs one test
+* function and checkDone() gives main() its exit code.
+*/
+
+static int checkFailures;
+static int checkCount;
+
+#define CHECK(cond) \
+    checkReport((cond), #cond, __FILE__, __LINE__)
+
+#define CHECK_EQ(a, b) \
+    checkEqual(static_cast<long long>(a), static_cast<long long>(b), #a, #b, __FILE__, __LINE__)
+
+#define RUN(test) do { \
+        int before = checkFailures; \
+        test(); \
+        printf("%-32s %s\n", #test, checkFailures == before ? "ok" : "FAILED"); \
+    } while (0)
+
+static inline bool checkReport(bool ok, const char *what, const char *file, int line) {
+    checkCount++;
+    if (!ok) {
+        checkFailures++;
+        printf("%s:%d: CHECK(%s) failed\n", file, line, what);
+    }
+    return ok;
+}
+
+static inline bool checkEqual(long long a, long long b, const char *as, const char *bs,
+        const char *file, int line) {
+    checkCount++;
+    if (a != b) {
+        checkFailures++;
+        printf("%s:%d: %s == %s failed, %lld != %lld\n", file, line, as, bs, a, b);
+    }
+    return a == b;
+}
+
+static inline int checkDone() {
+    printf("%d checks, %d failed\n", checkCount, checkFailures);
+    return checkFailures ? 1 : 0;
+}
+
+#endif /* CHECK_H_ */
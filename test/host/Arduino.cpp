@@ -0,0 +1,51 @@
+/*
+* Arduino.cpp - Host stand-in for the ESP8266 Arduino core, for the host tests
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "FS.h"
+#include "ESP8266WiFi.h"
+
+HardwareSerial Serial(UART0);
+HardwareSerial Serial1(UART1);
+SPIClass SPI;
+FS SPIFFS;
+ESP8266WiFiClass WiFi;
+
+static uint32_t seed = 1;
+
+/* Same sequence on every run, xorshift32 */
+static uint32_t next() {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+long random(long howbig) {
+    return howbig > 0 ? next() % howbig : 0;
+}
+
+long random(long howsmall, long howbig) {
+    return howsmall < howbig ? howsmall + random(howbig - howsmall) : howsmall;
+}
+
+void randomSeed(unsigned long s) {
+    seed = s ? s : 1;
+}
@@ -0,0 +1,239 @@
+/*
+* Arduino.h - Host stand-in for the ESP8266 Arduino core, for the host tests
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef ARDUINO_H_
+#define ARDUINO_H_
+
+/*
+* Only what the sources under test use. Time comes from HostSim, so
+* micros(), millis() and delayMicroseconds() follow the simulated UARTs.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <arpa/inet.h>
+#include <string>
+#include <algorithm>
+#include "HostSim.h"
+
+#define ICACHE_RAM_ATTR
+#define ICACHE_FLASH_ATTR
+#define PROGMEM
+#define F(s)                (s)
+#define pgm_read_byte(p)    (*(const uint8_t *)(p))
+#define strlen_P            strlen
+#define PI                  3.1415926535897932384626433832795
+
+typedef uint8_t byte;
+
+using std::min;
+using std::max;
+
+/* Time, from the simulation */
+inline unsigned long micros() {
+    return simNow() / SIM_PS_US;
+}
+
+inline unsigned long millis() {
+    return simNow() / (SIM_PS_US * 1000);
+}
+
+/* Busy waits let the simulation run, interrupts and all */
+inline void delayMicroseconds(unsigned int us) {
+    simRun(us);
+}
+
+inline void delay(unsigned long ms) {
+    simRun(ms * 1000);
+}
+
+inline void yield() {
+}
+
+#define INPUT       0x00
+#define OUTPUT      0x01
+#define SPECIAL     0xF8
+#define LOW         0
+#define HIGH        1
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t val) {
+}
+
+/* Repeatable random numbers, reseeded with randomSeed() */
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+/* timer1, TIM_DIV16 is the only divider the drivers use */
+#define TIM_DIV1    0
+#define TIM_DIV16   1
+#define TIM_DIV256  3
+#define TIM_EDGE    0
+#define TIM_SINGLE  0
+#define TIM_LOOP    1
+
+typedef void (*timercallback)(void);
+
+inline void timer1_isr_init() {
+}
+
+inline void timer1_attachInterrupt(timercallback userFunc) {
+    simTimerAttach(userFunc);
+}
+
+inline void timer1_enable(uint8_t divider, uint8_t int_type, uint8_t reload) {
+    simTimerEnable(true, divider == TIM_DIV256 ? 256 : divider == TIM_DIV16 ? 16 : 1);
+}
+
+inline void timer1_disable() {
+    simTimerEnable(false, 16);
+}
+
+inline void timer1_write(uint32_t ticks) {
+    simTimerWrite(ticks);
+}
+
+/* Arduino String on top of std::string */
+class String {
+ public:
+    String() {}
+    String(const char *s) : s(s ? s : "") {}
+    String(const std::string &s) : s(s) {}
+    explicit String(char c) : s(1, c) {}
+    String(int v) : s(std::to_string(v)) {}
+    String(unsigned int v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+    explicit String(float v) : s(std::to_string(v)) {}
+
+    unsigned int length() const {
+        return s.length();
+    }
+
+    const char *c_str() const {
+        return s.c_str();
+    }
+
+    explicit operator bool() const {
+        return true;
+    }
+
+    char operator[](unsigned int i) const {
+        return i < s.length() ? s[i] : 0;
+    }
+
+    bool operator==(const String &o) const {
+        return s == o.s;
+    }
+
+    bool operator!=(const String &o) const {
+        return s != o.s;
+    }
+
+    bool equalsIgnoreCase(const String &o) const {
+        return s.length() == o.s.length() &&
+                std::equal(s.begin(), s.end(), o.s.begin(), [](char a, char b) {
+                    return tolower(a) == tolower(b);
+                });
+    }
+
+    String substring(unsigned int from, unsigned int to) const {
+        return from < s.length() ? String(s.substr(from, to - from)) : String();
+    }
+
+    String substring(unsigned int from) const {
+        return from < s.length() ? String(s.substr(from)) : String();
+    }
+
+    int indexOf(char c) const {
+        size_t i = s.find(c);
+        return i == std::string::npos ? -1 : i;
+    }
+
+    long toInt() const {
+        return atol(s.c_str());
+    }
+
+    String &operator+=(const String &o) {
+        s += o.s;
+        return *this;
+    }
+
+    friend String operator+(const String &a, const String &b) {
+        return String(a.s + b.s);
+    }
+
+ private:
+    std::string s;
+};
+
+/* Serial ports, HardwareSerial sets up the simulated UART and otherwise keeps quiet */
+#define SERIAL_5N1      0x10
+#define SERIAL_6N1      0x14
+#define SERIAL_7N1      0x18
+#define SERIAL_8N1      0x1c
+#define SERIAL_8N2      0x3c
+#define SERIAL_FULL     0
+#define SERIAL_TX_ONLY  2
+
+class HardwareSerial {
+ public:
+    explicit HardwareSerial(uint8_t uart) : uart(uart) {}
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, uint8_t mode = SERIAL_FULL) {
+        simUartConfig(uart, baud, config);
+    }
+
+    void end() {
+    }
+
+    int available() {
+        return 0;
+    }
+
+    int read() {
+        return -1;
+    }
+
+    template <typename T> size_t print(const T &) {
+        return 0;
+    }
+
+    template <typename T> size_t println(const T &) {
+        return 0;
+    }
+
+    size_t println() {
+        return 0;
+    }
+
+ private:
+    uint8_t uart;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif /* ARDUINO_H_ */
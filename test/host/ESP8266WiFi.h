@@ -0,0 +1,91 @@
+/*
+* ESP8266WiFi.h - Host stand-in for the ESP8266 WiFi library
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef ESP8266WIFI_H_
+#define ESP8266WIFI_H_
+
+#include "Arduino.h"
+
+class IPAddress {
+ public:
+    IPAddress() : addr(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+            : addr(a | b << 8 | c << 16 | static_cast<uint32_t>(d) << 24) {}
+    IPAddress(uint32_t addr) : addr(addr) {}
+
+    operator uint32_t() const {
+        return addr;
+    }
+
+    uint8_t operator[](int i) const {
+        return addr >> (i * 8);
+    }
+
+ private:
+    uint32_t addr;
+};
+
+typedef struct {
+    IPAddress   ip;
+} WiFiEventStationModeGotIP;
+
+typedef struct {
+    uint8_t     reason;
+} WiFiEventStationModeDisconnected;
+
+class ESP8266WiFiClass {
+ public:
+    IPAddress localIP() {
+        return IPAddress(192, 168, 0, 2);
+    }
+
+    uint8_t *macAddress(uint8_t *mac) {
+        static const uint8_t MAC[6] = { 0x5c, 0xcf, 0x7f, 0x00, 0x00, 0x02 };
+        memcpy(mac, MAC, sizeof(MAC));
+        return mac;
+    }
+};
+
+extern ESP8266WiFiClass WiFi;
+
+/* Sends go nowhere */
+class WiFiUDP {
+ public:
+    uint8_t begin(uint16_t port) {
+        return 1;
+    }
+
+    int beginPacket(IPAddress ip, uint16_t port) {
+        return 1;
+    }
+
+    int beginPacketMulticast(IPAddress ip, uint16_t port, IPAddress local) {
+        return 1;
+    }
+
+    size_t write(const uint8_t *data, size_t size) {
+        return size;
+    }
+
+    int endPacket() {
+        return 1;
+    }
+};
+
+#endif /* ESP8266WIFI_H_ */
@@ -0,0 +1,109 @@
+/*
+* ESPAsyncUDP.h - Host stand-in, tests hand packets to the receivers by port
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef ESPASYNCUDP_H_
+#define ESPASYNCUDP_H_
+
+#include <functional>
+#include <map>
+#include <vector>
+#include "ESP8266WiFi.h"
+
+class AsyncUDPPacket {
+ public:
+    AsyncUDPPacket(const uint8_t *data, size_t length, IPAddress remote)
+            : buf(data), len(length), remote(remote) {}
+
+    uint8_t *data() {
+        return const_cast<uint8_t *>(buf);
+    }
+
+    size_t length() {
+        return len;
+    }
+
+    IPAddress remoteIP() {
+        return remote;
+    }
+
+ private:
+    const uint8_t   *buf;
+    size_t          len;
+    IPAddress       remote;
+};
+
+/*
+* Listening registers the socket against its port, AsyncUDP::inject()
+* delivers a packet there as the network task would. Replies are kept
+* in sent.
+*/
+class AsyncUDP {
+ public:
+    typedef std::function<void(AsyncUDPPacket)> handler_t;
+
+    std::vector<std::vector<uint8_t> >  sent;
+
+    ~AsyncUDP() {
+        for (auto it = sockets().begin(); it != sockets().end(); ) {
+            if (it->second == this)
+                it = sockets().erase(it);
+            else
+                ++it;
+        }
+    }
+
+    bool listen(uint16_t port) {
+        sockets()[port] = this;
+        return true;
+    }
+
+    bool listenMulticast(IPAddress group, uint16_t port) {
+        return listen(port);
+    }
+
+    void onPacket(handler_t handler) {
+        this->handler = handler;
+    }
+
+    size_t writeTo(const uint8_t *data, size_t len, IPAddress ip, uint16_t port) {
+        sent.push_back(std::vector<uint8_t>(data, data + len));
+        return len;
+    }
+
+    /* Deliver a packet to whoever listens on port, false if nobody does */
+    static bool inject(uint16_t port, const uint8_t *data, size_t len,
+            IPAddress remote = IPAddress(192, 168, 0, 10)) {
+        auto it = sockets().find(port);
+        if (it == sockets().end() || !it->second->handler)
+            return false;
+        it->second->handler(AsyncUDPPacket(data, len, remote));
+        return true;
+    }
+
+ private:
+    handler_t   handler;
+
+    /* Never freed, static receivers outlive any static map */
+    static std::map<uint16_t, AsyncUDP *> &sockets() {
+        static std::map<uint16_t, AsyncUDP *> *map = new std::map<uint16_t, AsyncUDP *>;
+        return *map;
+    }
+};
+
+#endif /* ESPASYNCUDP_H_ */
@@ -0,0 +1,91 @@
+/*
+* FS.h - Host stand-in for SPIFFS, files live in memory
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef FS_H_
+#define FS_H_
+
+#include <map>
+#include "Arduino.h"
+
+class File {
+ public:
+    File() : data(nullptr), pos(0) {}
+    explicit File(std::string *data) : data(data), pos(0) {}
+
+    explicit operator bool() const {
+        return data;
+    }
+
+    size_t write(const uint8_t *buf, size_t size) {
+        data->append(reinterpret_cast<const char *>(buf), size);
+        return size;
+    }
+
+    size_t print(const char *s) {
+        return write(reinterpret_cast<const uint8_t *>(s), strlen(s));
+    }
+
+    size_t read(uint8_t *buf, size_t size) {
+        size = std::min(size, data->size() - pos);
+        memcpy(buf, data->data() + pos, size);
+        pos += size;
+        return size;
+    }
+
+    size_t size() const {
+        return data->size();
+    }
+
+    void close() {
+        data = nullptr;
+    }
+
+ private:
+    std::string *data;
+    size_t      pos;
+};
+
+/* Tests can look at and change files through files */
+class FS {
+ public:
+    std::map<std::string, std::string>  files;
+
+    bool begin() {
+        return true;
+    }
+
+    File open(const char *path, const char *mode) {
+        if (mode[0] == 'w')
+            return File(&(files[path] = std::string()));
+        auto f = files.find(path);
+        return f == files.end() ? File() : File(&f->second);
+    }
+
+    bool exists(const char *path) {
+        return files.count(path);
+    }
+
+    bool remove(const char *path) {
+        return files.erase(path);
+    }
+};
+
+extern FS SPIFFS;
+
+#endif /* FS_H_ */
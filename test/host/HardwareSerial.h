@@ -0,0 +1,2 @@
+/* HardwareSerial lives in the host Arduino.h */
+#include "Arduino.h"
@@ -0,0 +1,405 @@
+/*
+* HostSim.cpp - Simulated ESP8266 peripherals for the host tests
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HostSim.h"
+
+#define SIM_ISR_LOOP    1000    /* Handler calls in a row before we call it stuck */
+
+sim_uart_t simUart[SIM_UARTS];
+sim_spi_t simSpi;
+
+static uint64_t simTime;                // Now, in ps
+static void     (*uartHandler)(void *); // Shared UART interrupt handler
+static bool     uartIsr;                // UART interrupt unmasked
+static void     (*timerHandler)();      // timer1 handler
+static bool     timerOn;                // timer1 enabled
+static bool     timerArmed;             // timer1 counting down
+static uint64_t timerAt;                // When it hits 0
+static uint64_t timerTick;              // ps per timer1 tick
+
+static inline uint64_t bitTime(const sim_uart_t &u) {
+    return u.div * SIM_PS_CLOCK;
+}
+
+static void setLevel(sim_uart_t &u, uint64_t time, bool level) {
+    if (u.level == level)
+        return;
+    u.level = level;
+    u.line.push_back({ time, level });
+}
+
+/* Line level for a logical bit, after inversion */
+static inline bool lineLevel(const sim_uart_t &u, bool bit) {
+    return bit != u.invert;
+}
+
+/* Move the oldest FIFO byte into the shifter and lay its bits on the line */
+static void startByte(sim_uart_t &u, uint64_t time) {
+    uint8_t byte = u.fifo[u.head];
+    u.head = (u.head + 1) % UART_TX_FIFO_SIZE;
+    u.count--;
+
+    uint64_t t = time;
+    setLevel(u, t, lineLevel(u, false));
+    for (uint8_t i = 0; i < u.bits; i++) {
+        t += bitTime(u);
+        setLevel(u, t, lineLevel(u, byte & (1 << i)));
+    }
+    t += bitTime(u);
+    setLevel(u, t, lineLevel(u, true));
+
+    u.busy = true;
+    u.busyUntil = t + u.stops * bitTime(u);
+}
+
+/* The shifter is done with a byte, start the next or hold the break */
+static void finishByte(sim_uart_t &u) {
+    u.busy = false;
+    if (u.count)
+        startByte(u, u.busyUntil);
+    else if (u.brk)
+        setLevel(u, u.busyUntil, lineLevel(u, false));
+}
+
+/* Call the UART handler for as long as it has something pending */
+static void service() {
+    if (!uartIsr || !uartHandler)
+        return;
+
+    for (int i = 0; simUartPending(UART0) || simUartPending(UART1); i++) {
+        if (i == SIM_ISR_LOOP) {
+            fprintf(stderr, "HostSim: UART interrupt never cleared\n");
+            abort();
+        }
+        uartHandler(NULL);
+    }
+}
+
+void simReset() {
+    simTime = 0;
+    for (uint8_t i = 0; i < SIM_UARTS; i++) {
+        sim_uart_t &u = simUart[i];
+        u.div = ESP8266_CLOCK / 115200;
+        u.bits = 8;
+        u.stops = 1;
+        u.invert = false;
+        u.brk = false;
+        u.head = 0;
+        u.count = 0;
+        u.threshold = 0;
+        u.txInt = false;
+        u.busy = false;
+        u.busyUntil = 0;
+        u.level = true;
+        u.written = 0;
+        u.overflows = 0;
+        u.line.clear();
+    }
+    simSpi.clock = 1000000;
+    simSpi.busyUntil = 0;
+    simSpi.chunks = 0;
+    simSpi.overruns = 0;
+    simSpi.sent.clear();
+    uartHandler = nullptr;
+    uartIsr = false;
+    timerHandler = nullptr;
+    timerOn = false;
+    timerArmed = false;
+    timerTick = SIM_PS_CLOCK;
+}
+
+void simRun(uint32_t us) {
+    const uint64_t end = simTime + us * SIM_PS_US;
+
+    service();
+    for (;;) {
+        uint64_t next = end;
+        for (uint8_t i = 0; i < SIM_UARTS; i++) {
+            if (simUart[i].busy && simUart[i].busyUntil < next)
+                next = simUart[i].busyUntil;
+        }
+        if (timerOn && timerArmed && timerAt < next)
+            next = timerAt;
+
+        simTime = next;
+        for (uint8_t i = 0; i < SIM_UARTS; i++) {
+            if (simUart[i].busy && simUart[i].busyUntil <= simTime)
+                finishByte(simUart[i]);
+        }
+        if (timerOn && timerArmed && timerAt <= simTime) {
+            timerArmed = false;
+            if (timerHandler)
+                timerHandler();
+        }
+        service();
+
+        if (simTime >= end)
+            break;
+    }
+}
+
+uint64_t simNow() {
+    return simTime;
+}
+
+uint32_t simCycleCount() {
+    return simTime / SIM_PS_CLOCK;
+}
+
+/* Config is the UART_CONF0 layout the SERIAL_xxx constants use */
+void simUartConfig(uint8_t uart, uint32_t baud, uint32_t config) {
+    sim_uart_t &u = simUart[uart];
+    u.div = ESP8266_CLOCK / baud;
+    u.bits = 5 + ((config >> 2) & 0x3);
+    u.stops = ((config >> 4) & 0x3) == 0x3 ? 2 : 1;
+}
+
+void simUartWrite(uint8_t uart, uint8_t byte) {
+    sim_uart_t &u = simUart[uart];
+    u.written++;
+    if (u.count == UART_TX_FIFO_SIZE) {
+        u.overflows++;
+        return;
+    }
+
+    u.fifo[(u.head + u.count) % UART_TX_FIFO_SIZE] = byte;
+    u.count++;
+    if (!u.busy)
+        startByte(u, simTime);
+}
+
+void simUartBreak(uint8_t uart, bool enable) {
+    sim_uart_t &u = simUart[uart];
+    u.brk = enable;
+    if (!u.busy)
+        setLevel(u, simTime, lineLevel(u, !enable));
+}
+
+void simUartInvert(uint8_t uart, bool invert) {
+    sim_uart_t &u = simUart[uart];
+    u.invert = invert;
+    if (!u.busy)
+        setLevel(u, simTime, lineLevel(u, !u.brk));
+}
+
+void simUartResetFifo(uint8_t uart) {
+    simUart[uart].count = 0;
+}
+
+bool simUartPending(uint8_t uart) {
+    const sim_uart_t &u = simUart[uart];
+    return u.txInt && u.count < u.threshold;
+}
+
+void simUartAttach(void (*handler)(void *)) {
+    uartHandler = handler;
+}
+
+void simUartIsrEnable(bool enable) {
+    uartIsr = enable;
+}
+
+void simSpiClock(uint32_t hz) {
+    simSpi.clock = hz;
+}
+
+bool simSpiBusy() {
+    if (simTime >= simSpi.busyUntil)
+        return false;
+    simRun(1);
+    return true;
+}
+
+void simSpiWrite(const uint8_t *data, uint8_t len) {
+    // Load whole words as the FIFO does, so reads past the buffer show up
+    uint32_t fifo[16];
+    memcpy(fifo, data, (len + 3) / 4 * 4);
+
+    if (simTime < simSpi.busyUntil)
+        simSpi.overruns++;
+    simSpi.sent.insert(simSpi.sent.end(), data, data + len);
+    simSpi.chunks++;
+    simSpi.busyUntil = simTime + len * 8 * (SIM_PS_US * 1000000ULL / simSpi.clock);
+}
+
+void simTimerAttach(void (*handler)()) {
+    timerHandler = handler;
+}
+
+void simTimerEnable(bool enable, uint8_t divider) {
+    timerOn = enable;
+    timerTick = SIM_PS_CLOCK * divider;
+    if (!enable)
+        timerArmed = false;
+}
+
+void simTimerWrite(uint32_t ticks) {
+    timerArmed = true;
+    timerAt = simTime + ticks * timerTick;
+}
+
+static inline bool near(uint64_t value, uint64_t target, uint64_t tolerance) {
+    return value + tolerance >= target && value <= target + tolerance;
+}
+
+/*
+* WS2811 bits are 1.25us: a 0 is high for one UART bit (312.5ns), a 1 for
+* three. Anything low for 50us or more is a reset and ends the frame.
+*/
+std::vector<sim_frame_t> decodeWS2811(const std::vector<sim_edge_t> &line,
+        uint64_t tolerance, uint32_t &errors) {
+    const uint64_t T_BIT = 1250000, T0H = 312500, T1H = 937500, T_RESET = 50 * SIM_PS_US;
+    std::vector<sim_frame_t> frames;
+    sim_frame_t *frame = nullptr;
+    uint8_t byte = 0, bits = 0;
+    uint64_t lastRise = 0;
+
+    errors = 0;
+    for (size_t i = 0; i + 1 < line.size(); i++) {
+        if (!line[i].level || line[i + 1].level)
+            continue;
+
+        uint64_t rise = line[i].time;
+        uint64_t high = line[i + 1].time - rise;
+
+        if (!frame || rise - lastRise >= T_RESET) {
+            if (bits)
+                errors++;
+            frames.push_back({ rise, 0, {} });
+            frame = &frames.back();
+            bits = 0;
+        } else if (!near(rise - lastRise, T_BIT, tolerance)) {
+            errors++;
+        }
+        lastRise = rise;
+
+        if (near(high, T1H, tolerance))
+            byte = byte << 1 | 1;
+        else if (near(high, T0H, tolerance))
+            byte = byte << 1;
+        else
+            errors++;
+
+        frame->end = line[i + 1].time;
+        if (++bits == 8) {
+            frame->data.push_back(byte);
+            bits = 0;
+        }
+    }
+    if (bits)
+        errors++;
+
+    return frames;
+}
+
+/*
+* GECE idles in break (low). A packet is a 10us high start bit then 26 bits
+* of 30us, MSB first, each low then high - a 1 is low for the longer part.
+*/
+std::vector<sim_gece_t> decodeGECE(const std::vector<sim_edge_t> &line,
+        uint64_t tolerance, uint32_t &errors) {
+    const uint64_t T_START = 10 * SIM_PS_US, T_BIT = 30 * SIM_PS_US;
+    std::vector<sim_gece_t> packets;
+
+    errors = 0;
+    size_t i = 0;
+    while (i + 1 < line.size()) {
+        if (!line[i].level) {
+            i++;
+            continue;
+        }
+
+        sim_gece_t packet = { line[i].time, line[i + 1].time - line[i].time, 0 };
+        if (!near(packet.startBit, T_START, tolerance))
+            errors++;
+
+        // Each bit runs from one falling edge to the next
+        i++;
+        for (uint8_t bit = 0; bit < 26; bit++, i += 2) {
+            if (i + 2 >= line.size()) {
+                errors++;
+                return packets;
+            }
+            uint64_t low = line[i + 1].time - line[i].time;
+            uint64_t high = line[i + 2].time - line[i + 1].time;
+            // The last bit's high part runs into the break
+            if (bit < 25 && !near(low + high, T_BIT, tolerance))
+                errors++;
+            packet.packet = packet.packet << 1 | (low > high ? 1 : 0);
+        }
+        packets.push_back(packet);
+        i++;
+    }
+
+    return packets;
+}
+
+/* Bytes are sampled mid bit, a start bit with a low stop bit is a break */
+std::vector<int> decodeSerial(const std::vector<sim_edge_t> &line,
+        uint32_t baud, uint8_t bits, uint8_t stops, uint32_t &errors) {
+    const uint64_t bt = (ESP8266_CLOCK / baud) * SIM_PS_CLOCK;
+    std::vector<int> bytes;
+
+    // Line level at time t
+    size_t cursor = 0;
+    bool level = true;
+    auto levelAt = [&](uint64_t t) {
+        while (cursor < line.size() && line[cursor].time <= t)
+            level = line[cursor++].level;
+        return level;
+    };
+
+    errors = 0;
+    size_t i = 0;
+    while (i < line.size()) {
+        if (line[i].level) {
+            i++;
+            continue;
+        }
+
+        uint64_t start = line[i].time;
+        int byte = 0;
+        for (uint8_t b = 0; b < bits; b++) {
+            if (levelAt(start + bt * (b + 1) + bt / 2))
+                byte |= 1 << b;
+        }
+
+        bool stop = true;
+        for (uint8_t s = 0; s < stops; s++)
+            stop &= levelAt(start + bt * (bits + 1 + s) + bt / 2);
+
+        if (stop) {
+            bytes.push_back(byte);
+        } else if (!byte) {
+            bytes.push_back(-1);
+        } else {
+            errors++;
+        }
+
+        // Next start bit is the first falling edge after this frame
+        uint64_t next = start + bt * (bits + 1);
+        while (i < line.size() && (line[i].time <= next || line[i].level))
+            i++;
+    }
+
+    return bytes;
+}
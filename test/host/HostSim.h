@@ -0,0 +1,143 @@
+/*
+* HostSim.h - Simulated ESP8266 peripherals for the host tests
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef HOSTSIM_H_
+#define HOSTSIM_H_
+
+#include <stdint.h>
+#include <vector>
+
+/*
+* Just enough of the chip for the output drivers: a clock, both UARTs,
+* timer1 and HSPI. Time only moves in simRun(), which shifts bytes out of the UART
+* FIFOs onto a timestamped line, fires timer1 and calls the UART interrupt
+* handler whenever a TX FIFO is below its threshold with the interrupt on.
+* Interrupt handlers take no time. Times are in picoseconds so the 12.5ns
+* UART clock steps come out exact.
+*/
+
+#define SIM_PS_US           1000000ULL  /* Picoseconds per microsecond */
+#define SIM_PS_CLOCK        12500ULL    /* Picoseconds per 80MHz clock */
+#define SIM_UARTS           2
+#define UART0               0
+#define UART1               1
+#define UART_TX_FIFO_SIZE   0x80
+#define ESP8266_CLOCK       80000000UL
+
+/* A change of the TX line level */
+typedef struct {
+    uint64_t    time;       // When, in ps
+    bool        level;      // Level from then on
+} sim_edge_t;
+
+/* Simulated UART, TX side only */
+typedef struct {
+    uint32_t    div;        // Clock divider, bit time is div clocks
+    uint8_t     bits;       // Data bits
+    uint8_t     stops;      // Stop bits
+    bool        invert;     // TX inverted
+    bool        brk;        // Break asserted, holds once the FIFO has drained
+    uint8_t     fifo[UART_TX_FIFO_SIZE];
+    uint8_t     head;       // Oldest byte in fifo
+    uint8_t     count;      // Bytes in fifo, not counting the one shifting out
+    uint8_t     threshold;  // TX empty interrupt below this many bytes
+    bool        txInt;      // TX empty interrupt enabled
+    bool        busy;       // A byte is shifting out
+    uint64_t    busyUntil;  // When it's done
+    bool        level;      // Line level now
+    uint32_t    written;    // Bytes written to the FIFO
+    uint32_t    overflows;  // Bytes written to a full FIFO
+    std::vector<sim_edge_t> line;   // Every level change since simReset()
+} sim_uart_t;
+
+extern sim_uart_t simUart[SIM_UARTS];
+
+/* Simulated HSPI, it takes a chunk at a time and is busy while clocking it out */
+typedef struct {
+    uint32_t    clock;      // SPI clock in Hz
+    uint64_t    busyUntil;  // When the chunk being sent is done
+    uint32_t    chunks;     // Chunks written
+    uint32_t    overruns;   // Chunks written while still busy
+    std::vector<uint8_t> sent;  // Every byte since simReset()
+} sim_spi_t;
+
+extern sim_spi_t simSpi;
+
+/* Back to time 0 with everything idle */
+void simReset();
+
+/* Run the simulation for us microseconds */
+void simRun(uint32_t us);
+
+/* Simulation time */
+uint64_t simNow();
+uint32_t simCycleCount();
+
+/* UART, for UartHal.h and HardwareSerial */
+void simUartConfig(uint8_t uart, uint32_t baud, uint32_t config);
+void simUartWrite(uint8_t uart, uint8_t byte);
+void simUartBreak(uint8_t uart, bool enable);
+void simUartInvert(uint8_t uart, bool invert);
+void simUartResetFifo(uint8_t uart);
+bool simUartPending(uint8_t uart);
+void simUartAttach(void (*handler)(void *));
+void simUartIsrEnable(bool enable);
+
+/* HSPI, for SpiHal.h and SPIClass. Polling a busy HSPI takes 1us */
+void simSpiClock(uint32_t hz);
+bool simSpiBusy();
+void simSpiWrite(const uint8_t *data, uint8_t len);
+
+/* timer1 */
+void simTimerAttach(void (*handler)());
+void simTimerEnable(bool enable, uint8_t divider);
+void simTimerWrite(uint32_t ticks);
+
+/*
+* Waveform decoders, they take a line as captured and give back what was
+* sent. Timing off by more than tolerance ps from the protocol counts as an
+* error, as do partial bytes.
+*/
+
+/* One WS2811 frame, ended by a reset */
+typedef struct {
+    uint64_t    start;          // First rising edge
+    uint64_t    end;            // Last falling edge
+    std::vector<uint8_t> data;  // Channel values in the order sent
+} sim_frame_t;
+
+/* WS2811 at 800KHz from the 3.2Mbps inverted 6N1 UART symbols */
+std::vector<sim_frame_t> decodeWS2811(const std::vector<sim_edge_t> &line,
+        uint64_t tolerance, uint32_t &errors);
+
+/* GECE packets, 26 bits each, from a break held line */
+typedef struct {
+    uint64_t    start;          // Rising edge of the start bit
+    uint64_t    startBit;       // Length of the start bit
+    uint32_t    packet;         // Address, brightness, blue, green, red
+} sim_gece_t;
+
+std::vector<sim_gece_t> decodeGECE(const std::vector<sim_edge_t> &line,
+        uint64_t tolerance, uint32_t &errors);
+
+/* Plain asynchronous serial, one entry per byte, breaks come out as -1 */
+std::vector<int> decodeSerial(const std::vector<sim_edge_t> &line,
+        uint32_t baud, uint8_t bits, uint8_t stops, uint32_t &errors);
+
+#endif /* HOSTSIM_H_ */
@@ -0,0 +1,57 @@
+/*
+* SPI.h - Host stand-in for the ESP8266 SPI library, for the host tests
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef SPI_H_
+#define SPI_H_
+
+#include "Arduino.h"
+
+#define SPI_MODE0   0x00
+#define MSBFIRST    1
+
+/* Goes to the simulated HSPI, which keeps what was sent */
+class SPIClass {
+ public:
+    uint32_t    frequency = 0;
+
+    void begin() {}
+    void end() {}
+    void setDataMode(uint8_t mode) {}
+    void setBitOrder(uint8_t order) {}
+
+    void setFrequency(uint32_t freq) {
+        frequency = freq;
+        simSpiClock(freq);
+    }
+
+    /* Blocks like the real one, a chunk at a time */
+    void writeBytes(const uint8_t *data, uint32_t size) {
+        while (size) {
+            while (simSpiBusy()) {}
+            uint8_t len = std::min(size, static_cast<uint32_t>(64));
+            simSpiWrite(data, len);
+            data += len;
+            size -= len;
+        }
+    }
+};
+
+extern SPIClass SPI;
+
+#endif /* SPI_H_ */
@@ -0,0 +1,31 @@
+/*
+* Ticker.h - Host stand-in for Ticker, nothing fires on its own
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef TICKER_H_
+#define TICKER_H_
+
+class Ticker {
+ public:
+    template <typename F> void attach(float seconds, F callback) {}
+    template <typename F> void once(float seconds, F callback) {}
+    template <typename F, typename A> void once(float seconds, F callback, A arg) {}
+    void detach() {}
+};
+
+#endif /* TICKER_H_ */
@@ -0,0 +1,29 @@
+/*
+* igmp.h - Host stand-in for lwIP's IGMP, joins go nowhere
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef LWIP_IGMP_H_
+#define LWIP_IGMP_H_
+
+#include "lwip/ip_addr.h"
+
+static inline int8_t igmp_joingroup(const ip4_addr_t *ifaddr, const ip4_addr_t *groupaddr) {
+    return 0;
+}
+
+#endif /* LWIP_IGMP_H_ */
@@ -0,0 +1,29 @@
+/*
+* ip_addr.h - Host stand-in for lwIP's IPv4 addresses
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#ifndef LWIP_IP_ADDR_H_
+#define LWIP_IP_ADDR_H_
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t    addr;
+} ip4_addr_t;
+
+#endif /* LWIP_IP_ADDR_H_ */
@@ -0,0 +1,112 @@
+/*
+* test_apa102.cpp - APA102 output fed to the simulated HSPI from loop()
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "PixelDriver.h"
+#include "check.h"
+
+#define LOOP_US     200     /* What the rest of loop() takes between update() calls */
+
+static PixelDriver pixels;
+
+/* The frame as encodeAPA102() makes it, with the driver's gamma and order */
+static std::vector<uint8_t> expected(const uint8_t *data, uint16_t count, uint8_t brightness) {
+    const uint8_t order[] = { 0, 1, 2, 3 };
+    std::vector<uint8_t> out(APA102_SIZE(count));
+    out.resize(PixelDriver::encodeAPA102(&out[0], data, count, order, brightness));
+    return out;
+}
+
+/*
+* show() loads a chunk and returns. Each update() feeds HSPI for at most
+* APA102_SLICE, the frame goes out whole with no chunk written over another.
+*/
+static void testFeed() {
+    const uint16_t count = 2048;
+    static uint8_t data[count * 3];
+    for (uint32_t i = 0; i < sizeof(data); i++)
+        data[i] = i * 13 + i / 7;
+
+    simReset();
+    updateGammaTable(1.0, 1.0);
+    PixelDriver::stats = {};
+    pixels.begin(PixelType::APA102, PixelColor::RGB, count);
+    pixels.setSPI(APA102_DEFAULT_CLOCK, APA102_MAX_BRIGHTNESS);
+    pixels.setData(data, sizeof(data));
+
+    uint64_t before = simNow();
+    pixels.show();
+    CHECK(simNow() - before <= APA102_SLICE * SIM_PS_US);
+    CHECK(!pixels.canRefresh());
+
+    // A loop() that does other work between updates
+    uint32_t loops = 0, longest = 0;
+    while (!pixels.canRefresh() && loops < 10000) {
+        uint64_t start = simNow();
+        pixels.update();
+        longest = std::max(longest, static_cast<uint32_t>((simNow() - start) / SIM_PS_US));
+        simRun(LOOP_US);
+        loops++;
+    }
+
+    CHECK(pixels.canRefresh());
+    CHECK(longest <= APA102_SLICE + 1);
+    CHECK(loops > 1);
+    CHECK_EQ(simSpi.overruns, 0);
+    CHECK_EQ(PixelDriver::stats.frames_done, 1);
+    CHECK(simSpi.sent == expected(data, count, APA102_MAX_BRIGHTNESS));
+    CHECK_EQ(simSpi.chunks, (APA102_SIZE(count) + SPI_CHUNK - 1) / SPI_CHUNK);
+}
+
+/* Nothing more goes to HSPI once begin() has started over */
+static void testRestart() {
+    const uint16_t count = 1000;
+    static uint8_t data[count * 3];
+    memset(data, 0x80, sizeof(data));
+
+    simReset();
+    PixelDriver::stats = {};
+    pixels.begin(PixelType::APA102, PixelColor::RGB, count);
+    pixels.setData(data, sizeof(data));
+    pixels.show();
+    pixels.update();
+    size_t sent = simSpi.sent.size();
+    CHECK(sent < APA102_SIZE(count));
+
+    pixels.begin(PixelType::APA102, PixelColor::RGB, 10);
+    pixels.update();
+    simRun(20000);
+    pixels.update();
+    CHECK_EQ(simSpi.sent.size(), sent);
+    CHECK_EQ(PixelDriver::stats.frames_done, 0);
+    CHECK(pixels.canRefresh());
+
+    // The new frame goes out in one go, it fits a slice
+    pixels.setData(data, 30);
+    pixels.show();
+    CHECK_EQ(simSpi.sent.size() - sent, APA102_SIZE(10));
+    CHECK_EQ(PixelDriver::stats.frames_done, 1);
+}
+
+int main() {
+    RUN(testFeed);
+    RUN(testRestart);
+    return checkDone();
+}
@@ -0,0 +1,126 @@
+/*
+* test_artnet.cpp - ArtDmx filtering and sequence numbers
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include <vector>
+#include "E131Rx.h"
+#include "ArtNetRx.h"
+#include "check.h"
+
+static ArtNetRx artnet(8);
+
+/* An ArtDmx for port with 512 channels */
+static void send(uint16_t port, uint8_t sequence) {
+    artnet_packet_t p = {};
+    memcpy(p.id, "Art-Net", 8);
+    p.opcode = ARTNET_OP_DMX;
+    p.protocol = htons(ARTNET_PROTOCOL);
+    p.sequence = sequence;
+    p.port_address = port;
+    p.length = htons(512);
+    AsyncUDP::inject(ARTNET_DEFAULT_PORT, p.raw, sizeof(p.raw));
+}
+
+/*
+* Send each ArtDmx for port and take it off the queue the way loop()
+* does, giving the sequence numbers accept() passed. seqDiffs gets what
+* accept() said of every packet.
+*/
+static std::vector<uint8_t> receive(uint16_t port, std::vector<uint8_t> sequences,
+        std::vector<int8_t> &seqDiffs) {
+    std::vector<uint8_t> out;
+    seqDiffs.clear();
+    for (uint8_t s : sequences) {
+        send(port, s);
+        artnet_packet_t *packet = artnet.borrow();
+        if (!packet)
+            continue;
+        int8_t seqDiff;
+        if (artnet.accept(packet, seqDiff))
+            out.push_back(packet->sequence);
+        seqDiffs.push_back(seqDiff);
+        artnet.release();
+    }
+    return out;
+}
+
+static void start() {
+    simReset();
+    while (artnet.borrow())
+        artnet.release();
+    artnet.stats = {};
+    artnet.begin("ESPS", "ESPixelStick");
+    artnet.setUniverses(0, 3);
+}
+
+/* Duplicates and packets up to E131_SEQ_WINDOW behind are dropped, gaps counted */
+static void testWindow() {
+    start();
+    std::vector<int8_t> seqDiffs;
+    CHECK(receive(0, { 1, 2, 3, 3, 2, 4, 10, 9, 11 }, seqDiffs) ==
+            std::vector<uint8_t>({ 1, 2, 3, 4, 10, 11 }));
+    CHECK(seqDiffs == std::vector<int8_t>({ 0, 0, 0, -1, -2, 0, 5, -2, 0 }));
+    CHECK_EQ(artnet.stats.late, 3);
+    CHECK_EQ(artnet.stats.seq_errors, 1);
+
+    // Further back than the window the sender restarted, 12 was next
+    uint8_t restart = 255 + 12 - E131_SEQ_WINDOW - 1;
+    CHECK(receive(0, { restart, static_cast<uint8_t>(restart + 1) }, seqDiffs) ==
+            std::vector<uint8_t>({ restart, static_cast<uint8_t>(restart + 1) }));
+    CHECK(seqDiffs == std::vector<int8_t>({ -E131_SEQ_WINDOW - 1, 0 }));
+    CHECK_EQ(artnet.stats.late, 3);
+}
+
+/* 255 is followed by 1, and 0 means the sender doesn't number packets */
+static void testWrap() {
+    start();
+    std::vector<int8_t> seqDiffs;
+    CHECK(receive(1, { 253, 254, 255, 1, 2, 255, 0, 0, 3 }, seqDiffs) ==
+            std::vector<uint8_t>({ 253, 254, 255, 1, 2, 0, 0, 3 }));
+    CHECK(seqDiffs == std::vector<int8_t>({ 0, 0, 0, 0, 0, -3, 0, 0, 0 }));
+    CHECK_EQ(artnet.stats.seq_errors, 0);
+    CHECK_EQ(artnet.stats.late, 1);
+}
+
+/* Each port-address has its own sequence, others aren't queued */
+static void testPorts() {
+    start();
+    std::vector<int8_t> seqDiffs;
+    CHECK(receive(0, { 50 }, seqDiffs).size() == 1);
+    CHECK(receive(2, { 10 }, seqDiffs).size() == 1);
+    CHECK(receive(0, { 51 }, seqDiffs).size() == 1);
+    CHECK(receive(2, { 11, 10 }, seqDiffs) == std::vector<uint8_t>({ 11 }));
+    CHECK(receive(4, { 1 }, seqDiffs).empty());
+    CHECK(seqDiffs.empty());
+    CHECK_EQ(artnet.stats.filtered, 1);
+    CHECK_EQ(artnet.stats.late, 1);
+    CHECK_EQ(artnet.stats.seq_errors, 0);
+
+    // A new window starts the sequences over
+    artnet.setUniverses(0, 3);
+    CHECK(receive(0, { 40 }, seqDiffs) == std::vector<uint8_t>({ 40 }));
+    CHECK(seqDiffs == std::vector<int8_t>({ 0 }));
+}
+
+int main() {
+    RUN(testWindow);
+    RUN(testWrap);
+    RUN(testPorts);
+    return checkDone();
+}
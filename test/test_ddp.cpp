@@ -0,0 +1,225 @@
+/*
+* test_ddp.cpp - DDP packets through the receive queue into the input frame
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include <vector>
+#include "DdpRx.h"
+#include "InputFrame.h"
+#include "check.h"
+
+#define SIZE    3000    /* Frame bytes, 1000 RGB pixels */
+#define SLOTS   8
+
+typedef std::vector<uint8_t> bytes_t;
+
+static DdpRx        ddp(SLOTS);
+static InputFrame   input;
+static bytes_t      shown;      // Last frame handed to the output
+static uint32_t     latched;    // Frames handed to the output
+
+/* One DDP packet as it comes off the wire */
+static bytes_t packet(uint32_t offset, const uint8_t *data, uint16_t len, uint8_t flags = 0,
+        uint8_t seq = 0) {
+    bytes_t p = { static_cast<uint8_t>(DDP_FLAG_VER1 | flags), seq, 0x0b, DDP_ID_DISPLAY,
+            static_cast<uint8_t>(offset >> 24), static_cast<uint8_t>(offset >> 16),
+            static_cast<uint8_t>(offset >> 8), static_cast<uint8_t>(offset),
+            static_cast<uint8_t>(len >> 8), static_cast<uint8_t>(len) };
+    if (flags & DDP_FLAG_TIMECODE)
+        p.insert(p.end(), { 0x12, 0x34, 0x56, 0x78 });
+    p.insert(p.end(), data, data + len);
+    return p;
+}
+
+/* A frame split the way xLights sends it, PUSH on the last packet or on none */
+static std::vector<bytes_t> frame(const bytes_t &data, bool push, uint8_t &seq) {
+    std::vector<bytes_t> packets;
+    for (uint32_t offset = 0; offset < data.size(); offset += DDP_MAX_DATA) {
+        uint16_t len = std::min(static_cast<size_t>(DDP_MAX_DATA), data.size() - offset);
+        bool last = offset + len == data.size();
+        seq = seq % 15 + 1;
+        packets.push_back(packet(offset, &data[offset], len, last && push ? DDP_FLAG_PUSH : 0, seq));
+    }
+    return packets;
+}
+
+static bytes_t pattern(uint8_t seed) {
+    bytes_t data(SIZE);
+    for (uint32_t i = 0; i < SIZE; i++)
+        data[i] = i * 7 + seed;
+    return data;
+}
+
+static void send(const std::vector<bytes_t> &packets) {
+    for (const bytes_t &p : packets)
+        AsyncUDP::inject(DDP_DEFAULT_PORT, &p[0], p.size());
+}
+
+/* Drain the queue and time out partial frames the way loop() does */
+static void drain() {
+    ddp_packet_t *packet;
+    input.drain();
+    for (uint8_t i = 0; i < SLOTS && (packet = ddp.borrow()); i++) {
+        if (ddp.pushQueued() > 1)
+            input.stats.superseded++;
+        else if (input.write(DdpRx::offset(packet), DdpRx::data(packet),
+                DdpRx::length(packet), DdpRx::isPush(packet))) {
+            shown.assign(input.getData(), input.getData() + input.getSize());
+            latched++;
+        }
+        ddp.release();
+    }
+    if (input.poll()) {
+        shown.assign(input.getData(), input.getData() + input.getSize());
+        latched++;
+    }
+}
+
+static void start() {
+    simReset();
+    simRun(1000);
+    ddp.stats = {};
+    while (ddp.borrow())
+        ddp.release();
+    ddp.begin();
+    input.begin(SIZE, 1, 1);
+    input.stats = {};
+    shown.clear();
+    latched = 0;
+}
+
+/* PUSH latches the frame, and only once it's all in */
+static void testPush() {
+    start();
+    uint8_t seq = 0;
+    bytes_t data = pattern(1);
+    std::vector<bytes_t> packets = frame(data, true, seq);
+    CHECK_EQ(packets.size(), 3);
+
+    send({ packets[0], packets[1] });
+    drain();
+    CHECK_EQ(latched, 0);
+    send({ packets[2] });
+    drain();
+    CHECK_EQ(latched, 1);
+    CHECK(shown == data);
+    CHECK_EQ(input.stats.frames_complete, 1);
+    CHECK_EQ(ddp.stats.num_packets, 3);
+    CHECK_EQ(ddp.stats.push_packets, 1);
+    CHECK_EQ(ddp.stats.seq_errors, 0);
+
+    // With a PUSH sender about, writing the end doesn't latch
+    data = pattern(2);
+    packets = frame(data, false, seq);
+    send(packets);
+    drain();
+    CHECK_EQ(latched, 1);
+
+    // Until PUSH stops for long enough
+    simRun(INPUT_PUSH_TIMEOUT * 1000);
+    send({ packets.back() });
+    drain();
+    CHECK_EQ(latched, 2);
+    CHECK(shown == data);
+}
+
+/* Without PUSH the end of the buffer latches, a frame that stops short times out */
+static void testNoPush() {
+    start();
+    uint8_t seq = 0;
+    bytes_t data = pattern(3);
+    send(frame(data, false, seq));
+    drain();
+    CHECK_EQ(latched, 1);
+    CHECK(shown == data);
+
+    data = pattern(4);
+    std::vector<bytes_t> packets = frame(data, false, seq);
+    send({ packets[0] });
+    drain();
+    simRun((INPUT_FRAME_TIMEOUT - 1) * 1000);
+    drain();
+    CHECK_EQ(latched, 1);
+    simRun(1000);
+    drain();
+    CHECK_EQ(latched, 2);
+    CHECK_EQ(input.stats.frames_partial, 1);
+    CHECK(std::equal(shown.begin(), shown.begin() + DDP_MAX_DATA, data.begin()));
+}
+
+/* Two whole frames queued, the older one is dropped unseen */
+static void testSuperseded() {
+    start();
+    uint8_t seq = 0;
+    bytes_t older = pattern(5);
+    bytes_t newer = pattern(6);
+    send(frame(older, true, seq));
+    send(frame(newer, true, seq));
+    CHECK_EQ(ddp.pushQueued(), 2);
+    drain();
+    CHECK_EQ(latched, 1);
+    CHECK(shown == newer);
+    CHECK_EQ(input.stats.superseded, 3);
+    CHECK_EQ(ddp.pushQueued(), 0);
+}
+
+/* Timecodes, packets past the end and bad packets */
+static void testPackets() {
+    start();
+    bytes_t data = pattern(7);
+    send({ packet(0, &data[0], 100, DDP_FLAG_TIMECODE) });
+    send({ packet(SIZE - 50, &data[0], 100, DDP_FLAG_PUSH) });
+    drain();
+    send({ packet(SIZE + 10, &data[0], 100, DDP_FLAG_PUSH) });
+    drain();
+    CHECK_EQ(latched, 2);
+    CHECK(std::equal(data.begin(), data.begin() + 100, shown.begin()));
+    CHECK(std::equal(data.begin(), data.begin() + 50, shown.begin() + SIZE - 50));
+
+    bytes_t bad = packet(0, &data[0], 100);
+    bad[0] = 0x80;
+    send({ bad });
+    bad = packet(0, &data[0], 100);
+    bad.resize(50);
+    send({ bad });
+    bad = packet(0, &data[0], 100, DDP_FLAG_QUERY);
+    send({ bad });
+    bad = packet(0, &data[0], 100);
+    bad[3] = 7;
+    send({ bad });
+    CHECK_EQ(ddp.stats.packet_errors, 2);
+    CHECK(ddp.isEmpty());
+
+    // Sequence gaps are counted, 0 isn't numbered
+    uint8_t seq = 0;
+    std::vector<bytes_t> packets = frame(data, true, seq);
+    send({ packets[0] });
+    uint32_t errors = ddp.stats.seq_errors;
+    send({ packets[1] });
+    CHECK_EQ(ddp.stats.seq_errors, errors);
+    send({ packets[0] });
+    CHECK_EQ(ddp.stats.seq_errors, errors + 1);
+}
+
+int main() {
+    RUN(testPush);
+    RUN(testNoPush);
+    RUN(testSuperseded);
+    RUN(testPackets);
+    return checkDone();
+}
@@ -0,0 +1,143 @@
+/*
+* test_e131.cpp - E1.31 packet validation and universe filtering
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include <vector>
+#include "E131Rx.h"
+#include "check.h"
+
+static const uint8_t ACN_ID[12] = {
+    0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00
+};
+
+static E131Rx e131(8);
+
+/* A data packet for universe with count channels */
+static e131_packet_t data(uint16_t universe, uint16_t count) {
+    e131_packet_t p = {};
+    p.preamble_size = htons(E131_PREAMBLE_SIZE);
+    p.postamble_size = htons(E131_POSTAMBLE_SIZE);
+    memcpy(p.acn_id, ACN_ID, sizeof(ACN_ID));
+    p.root_vector = htonl(VECTOR_ROOT_E131_DATA);
+    p.frame_vector = htonl(VECTOR_E131_DATA_PACKET);
+    p.priority = 100;
+    p.universe = htons(universe);
+    p.dmp_vector = VECTOR_DMP_SET_PROPERTY;
+    p.type = E131_DMP_TYPE;
+    p.address_increment = htons(1);
+    p.property_value_count = htons(count + 1);
+    return p;
+}
+
+static void send(uint16_t universe, uint16_t count = 512) {
+    e131_packet_t p = data(universe, count);
+    AsyncUDP::inject(E131_DEFAULT_PORT, p.raw, E131_DATA_MIN_SIZE + count);
+}
+
+static void sendSync(uint16_t address) {
+    e131_packet_t p = {};
+    p.preamble_size = htons(E131_PREAMBLE_SIZE);
+    p.postamble_size = htons(E131_POSTAMBLE_SIZE);
+    memcpy(p.acn_id, ACN_ID, sizeof(ACN_ID));
+    p.root_vector = htonl(VECTOR_ROOT_E131_EXTENDED);
+    p.sync_vector = htonl(VECTOR_E131_EXTENDED_SYNCHRONIZATION);
+    p.sync_universe = htons(address);
+    AsyncUDP::inject(E131_DEFAULT_PORT, p.raw, E131_SYNC_SIZE);
+}
+
+/* Universes of the queued packets, emptying the queue */
+static std::vector<uint16_t> drain() {
+    std::vector<uint16_t> out;
+    e131_packet_t *packet;
+    while ((packet = e131.borrow())) {
+        out.push_back(E131Rx::isSync(packet) ? 0 : ntohs(packet->universe));
+        e131.release();
+    }
+    return out;
+}
+
+static void start() {
+    simReset();
+    e131.stats = {};
+    drain();
+    e131.begin(E131_UNICAST);
+}
+
+/* Only the window is queued, less the universes it doesn't use */
+static void testFilter() {
+    start();
+    e131.setUniverses(10, 14);
+    e131.ignoreUniverse(11);
+    e131.ignoreUniverse(13);
+    e131.ignoreUniverse(20);
+    for (uint16_t u = 9; u <= 15; u++)
+        send(u);
+    sendSync(11);
+
+    CHECK(drain() == std::vector<uint16_t>({ 10, 12, 14, 0 }));
+    CHECK_EQ(e131.stats.filtered, 4);
+    CHECK_EQ(e131.stats.num_packets, 4);
+
+    // A new window wants all of itself again
+    e131.setUniverses(11, 12);
+    send(11);
+    send(12);
+    send(13);
+    CHECK(drain() == std::vector<uint16_t>({ 11, 12 }));
+    CHECK_EQ(e131.stats.filtered, 5);
+}
+
+/* Past E131_UNIVERSES into the window there's no bitmap, all are wanted */
+static void testWide() {
+    start();
+    e131.setUniverses(1, 1000);
+    e131.ignoreUniverse(1);
+    e131.ignoreUniverse(E131_UNIVERSES);
+    e131.ignoreUniverse(E131_UNIVERSES + 1);
+    send(1);
+    send(E131_UNIVERSES);
+    send(E131_UNIVERSES + 1);
+    CHECK(drain() == std::vector<uint16_t>({ E131_UNIVERSES + 1 }));
+}
+
+/* Malformed packets never get as far as the filter */
+static void testErrors() {
+    start();
+    e131.setUniverses(1, 1);
+    e131_packet_t p = data(1, 512);
+    AsyncUDP::inject(E131_DEFAULT_PORT, p.raw, E131_DATA_MIN_SIZE + 100);
+    p = data(1, 513);
+    AsyncUDP::inject(E131_DEFAULT_PORT, p.raw, sizeof(p.raw));
+    p = data(1, 10);
+    p.acn_id[0] = 0;
+    AsyncUDP::inject(E131_DEFAULT_PORT, p.raw, E131_DATA_MIN_SIZE + 10);
+    CHECK_EQ(e131.stats.packet_errors, 3);
+    CHECK_EQ(e131.stats.filtered, 0);
+    CHECK(drain().empty());
+
+    send(1, 0);
+    CHECK_EQ(drain().size(), 1);
+}
+
+int main() {
+    RUN(testFilter);
+    RUN(testWide);
+    RUN(testErrors);
+    return checkDone();
+}
@@ -0,0 +1,136 @@
+/*
+* test_effects.cpp - Effect engine scheduling on its own clock
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include "ESPixelStick.h"
+#include "check.h"
+
+#define LEDS    200
+#define STEP    20      /* ms per Chase step with the delay below */
+#define SHOW_US 10000   /* Long enough to send a frame of LEDS */
+
+config_t            config;
+static PixelDriver  pixels;
+static EffectEngine effects;
+static uint32_t     clockMs;
+
+static EffectEngine::timeType testClock() {
+    return clockMs;
+}
+
+/* Chase lights one led per step, where the shown one is counts the steps */
+static int position() {
+    const uint8_t *data = pixels.getData();
+    for (uint16_t i = 0; i < LEDS; i++) {
+        if (data[i * 3])
+            return i;
+    }
+    return -1;
+}
+
+/* Move the clock on and run the engine as loop() would, showing what changed */
+static void runAt(uint32_t ms) {
+    clockMs = ms;
+    effects.run();
+    if (pixels.isDirty()) {
+        pixels.show();
+        simRun(SHOW_US);
+    }
+}
+
+static void start() {
+    simReset();
+    clockMs = 1000;
+    config.ds = DataSource::WEB;
+    pixels.begin(PixelType::WS2811, PixelColor::RGB, LEDS);
+    effects.setClock(testClock);
+    effects.begin(&pixels, LEDS);
+    effects.setColor({ 255, 0, 0 });
+    effects.setDelay(STEP * 32);
+    effects.setEffect("Solid");
+    effects.setEffect("Chase");
+    simRun(SHOW_US);
+}
+
+/* Steps land on multiples of STEP from the start however run() is called */
+static void testFixedStep() {
+    start();
+    runAt(1000);
+    CHECK_EQ(position(), 0);
+
+    bool onTime = true;
+    for (uint32_t t = 1000; t < 1000 + 100 * STEP; t += 7) {
+        runAt(t);
+        onTime &= position() == static_cast<int>((t - 1000) / STEP);
+    }
+    CHECK(onTime);
+}
+
+/* Late steps run back to back, up to EFFECT_CATCHUP, then the schedule restarts */
+static void testCatchUp() {
+    start();
+    runAt(1000);
+    runAt(1000 + 3 * STEP);
+    CHECK_EQ(position(), 3);
+
+    runAt(1000 + 20 * STEP);
+    CHECK_EQ(position(), 3 + EFFECT_CATCHUP);
+
+    // Then from where the schedule restarted
+    runAt(1000 + 20 * STEP + 1);
+    CHECK_EQ(position(), 4 + EFFECT_CATCHUP);
+    runAt(1000 + 21 * STEP - 1);
+    CHECK_EQ(position(), 4 + EFFECT_CATCHUP);
+    runAt(1000 + 21 * STEP);
+    CHECK_EQ(position(), 5 + EFFECT_CATCHUP);
+}
+
+/* Coming back from E1.31, or set again, the effect takes one step and carries on */
+static void testResume() {
+    start();
+    runAt(1000);
+    runAt(1000 + STEP);
+    CHECK_EQ(position(), 1);
+
+    config.ds = DataSource::E131;
+    for (uint32_t t = 1100; t < 5000; t += 100)
+        runAt(t);
+    config.ds = DataSource::IDLEWEB;
+    runAt(5000);
+    CHECK_EQ(position(), 2);
+    runAt(5000 + STEP - 1);
+    CHECK_EQ(position(), 2);
+    runAt(5000 + STEP);
+    CHECK_EQ(position(), 3);
+
+    // loop() stalled, then the same effect set again
+    clockMs = 9000;
+    effects.setEffect("Chase");
+    runAt(9000);
+    CHECK_EQ(position(), 4);
+    runAt(9000 + STEP);
+    CHECK_EQ(position(), 5);
+}
+
+int main() {
+    RUN(testFixedStep);
+    RUN(testCatchUp);
+    RUN(testResume);
+    return checkDone();
+}
@@ -0,0 +1,167 @@
+/*
+* test_gece.cpp - GECE output from the timer1 state machine
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include "PixelDriver.h"
+#include "check.h"
+
+#define TOLERANCE   (200000ULL)     /* 0.2us, GECE bits are 30us */
+
+static PixelDriver pixels;
+
+/* What packGECE should make of a bulb, top nibble of each color */
+static uint32_t expected(uint8_t bulb, const uint8_t *rgb) {
+    return static_cast<uint32_t>(bulb) << 20 | GECE_DEFAULT_BRIGHTNESS << 12 |
+            (rgb[2] >> 4) << 8 | (rgb[1] >> 4) << 4 | rgb[0] >> 4;
+}
+
+/*
+* Every bulb gets its address, default brightness and colors in a 26 bit
+* packet, after a 10us start bit, one packet every frame time.
+*/
+static void testPackets() {
+    const uint8_t count = 50;
+    uint8_t data[count * 3];
+    for (uint16_t i = 0; i < sizeof(data); i++)
+        data[i] = i * 37;
+
+    simReset();
+    PixelDriver::stats = {};
+    pixels.begin(PixelType::GECE, PixelColor::RGB, count);
+    pixels.setData(data, sizeof(data));
+
+    // show() only arms the timer
+    uint64_t before = simNow();
+    pixels.show();
+    CHECK_EQ(simNow(), before);
+    CHECK_EQ(PixelDriver::stats.frames_done, 0);
+
+    simRun(count * (GECE_TFRAME + GECE_TIDLE) + 1000);
+    CHECK_EQ(PixelDriver::stats.frames_done, 1);
+
+    uint32_t errors;
+    std::vector<sim_gece_t> packets = decodeGECE(simUart[UART1].line, TOLERANCE, errors);
+    CHECK_EQ(errors, 0);
+    CHECK_EQ(packets.size(), count);
+    if (packets.size() != count)
+        return;
+
+    bool match = true;
+    for (uint8_t bulb = 0; bulb < count; bulb++)
+        match &= packets[bulb].packet == expected(bulb, data + bulb * 3);
+    CHECK(match);
+
+    // Start bit, frame time, and the line back in break between packets
+    bool timing = true;
+    for (uint8_t bulb = 0; bulb < count; bulb++) {
+        timing &= packets[bulb].startBit >= GECE_TSTART * SIM_PS_US &&
+                packets[bulb].startBit < GECE_TSTART * SIM_PS_US + TOLERANCE;
+        if (bulb)
+            timing &= packets[bulb].start - packets[bulb - 1].start ==
+                    (GECE_TFRAME + GECE_TIDLE) * SIM_PS_US;
+    }
+    CHECK(timing);
+    CHECK_EQ(packets[0].start - before, GECE_TIDLE * SIM_PS_US);
+    CHECK(!simUart[UART1].line.back().level);
+
+    // The refresh time covers it
+    CHECK(pixels.canRefresh());
+    CHECK(simUart[UART1].line.back().time - before <= count * (GECE_TFRAME + GECE_TIDLE) * SIM_PS_US);
+}
+
+/* Each color lands in its own nibble, only the top nibble counts */
+static void testBits() {
+    const uint8_t data[] = { 0x10, 0x20, 0x40, 0x80, 0xf0, 0x00, 0x00, 0x00, 0xf0 };
+
+    simReset();
+    pixels.begin(PixelType::GECE, PixelColor::RGB, 3);
+    pixels.setData(data, sizeof(data));
+    pixels.show();
+    simRun(3 * (GECE_TFRAME + GECE_TIDLE) + 100);
+
+    uint32_t errors;
+    std::vector<sim_gece_t> packets = decodeGECE(simUart[UART1].line, TOLERANCE, errors);
+    CHECK_EQ(errors, 0);
+    CHECK_EQ(packets.size(), 3);
+    if (packets.size() == 3) {
+        CHECK_EQ(packets[0].packet, 0x00cc421);
+        CHECK_EQ(packets[1].packet, 0x01cc0f8);
+        CHECK_EQ(packets[2].packet, 0x02ccf00);
+    }
+}
+
+/* Changing the type mid frame stops the timer before the buffers go */
+static void testRestart() {
+    uint8_t data[20 * 3];
+    memset(data, 0xff, sizeof(data));
+
+    simReset();
+    PixelDriver::stats = {};
+    pixels.begin(PixelType::GECE, PixelColor::RGB, 20);
+    pixels.setData(data, sizeof(data));
+    pixels.show();
+    simRun(5 * (GECE_TFRAME + GECE_TIDLE));
+
+    pixels.begin(PixelType::WS2811, PixelColor::RGB, 20);
+    size_t edges = simUart[UART1].line.size();
+    simRun(20 * (GECE_TFRAME + GECE_TIDLE));
+
+    // What was on the line when it stopped at most, no more packets
+    uint32_t errors;
+    std::vector<sim_gece_t> packets = decodeGECE(simUart[UART1].line, TOLERANCE, errors);
+    CHECK(packets.size() <= 6);
+    CHECK(simUart[UART1].line.size() <= edges + 60);
+    CHECK_EQ(PixelDriver::stats.frames_done, 0);
+
+    // And the new type runs
+    pixels.setData(data, sizeof(data));
+    pixels.show();
+    simRun(1000);
+    CHECK_EQ(PixelDriver::stats.frames_done, 1);
+}
+
+/* Same for WS2811, the UART interrupt is off before the buffers go */
+static void testRestartWS2811() {
+    uint8_t data[200 * 3];
+    memset(data, 0x55, sizeof(data));
+
+    simReset();
+    PixelDriver::stats = {};
+    pixels.begin(PixelType::WS2811, PixelColor::RGB, 200);
+    pixels.setData(data, sizeof(data));
+    pixels.show();
+    simRun(500);
+
+    pixels.begin(PixelType::WS2811, PixelColor::RGB, 10);
+    simRun(10000);
+    CHECK_EQ(PixelDriver::stats.frames_done, 0);
+    CHECK(!simUartPending(UART1));
+
+    pixels.show();
+    simRun(1000);
+    CHECK_EQ(PixelDriver::stats.frames_done, 1);
+}
+
+int main() {
+    RUN(testPackets);
+    RUN(testBits);
+    RUN(testRestart);
+    RUN(testRestartWS2811);
+    return checkDone();
+}
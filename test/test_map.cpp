@@ -0,0 +1,191 @@
+/*
+* test_map.cpp - Universe to frame mapping from the patch table
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include <vector>
+#include "UniverseMap.h"
+#include "check.h"
+
+#define FIRST   10      /* First universe of the window */
+#define SIZE    600     /* Frame channels */
+
+static UniverseMap map;
+
+/* Channel ch of universe uni as its sender fills it, never 0 */
+static uint8_t channel(uint8_t uni, uint16_t ch) {
+    return 1 + uni * 37 + ch % 29;
+}
+
+/*
+* Copy each universe into the frame the way ingestUniverse() does, in the
+* given order. Returns the frame, and how many slices wrote each channel
+* in writes.
+*/
+static std::vector<uint8_t> render(const std::vector<uint8_t> &order, std::vector<uint8_t> &writes) {
+    std::vector<uint8_t> frame(SIZE, 0);
+    writes.assign(SIZE, 0);
+    for (uint8_t uni : order) {
+        uint8_t data[512];
+        for (uint16_t ch = 0; ch < sizeof(data); ch++)
+            data[ch] = channel(uni, ch);
+
+        if (!map.isMapped(uni))
+            continue;
+        uint16_t count;
+        const uni_slice_t *slices = map.slices(uni, count);
+        for (uint16_t i = 0; i < count; i++) {
+            memcpy(&frame[slices[i].dst], data + slices[i].src, slices[i].len);
+            for (uint16_t c = 0; c < slices[i].len; c++)
+                writes[slices[i].dst + c]++;
+        }
+    }
+    return frame;
+}
+
+/* What the frame should hold, walking the table with later entries on top */
+static std::vector<uint8_t> expected(const patch_t *patch, uint8_t count) {
+    std::vector<uint8_t> frame(SIZE, 0);
+    for (uint8_t i = 0; i < count; i++) {
+        for (uint16_t c = 0; c < patch[i].length; c++)
+            frame[patch[i].offset + c] = channel(patch[i].universe - FIRST, patch[i].channel - 1 + c);
+    }
+    return frame;
+}
+
+/* No channel written twice, and the same frame whichever universe comes in last */
+static void checkTable(const patch_t *patch, uint8_t count, uint8_t universes) {
+    map.begin(patch, count, FIRST, universes);
+
+    std::vector<uint8_t> forward, backward, writes;
+    for (uint8_t u = 0; u < universes; u++)
+        forward.push_back(u);
+    backward.assign(forward.rbegin(), forward.rend());
+
+    bool once = true;
+    CHECK(render(forward, writes) == expected(patch, count));
+    for (uint8_t w : writes)
+        once &= w <= 1;
+    CHECK(once);
+    CHECK(render(backward, writes) == expected(patch, count));
+}
+
+/* A later patch from another universe cuts a hole in an earlier one */
+static void testOverlap() {
+    const patch_t patch[] = {
+        { FIRST, 1, 0, 100 },
+        { FIRST + 1, 1, 50, 20 },
+    };
+    CHECK_EQ(map.begin(patch, 2, FIRST, 2), 2);
+
+    uint16_t count;
+    const uni_slice_t *s = map.slices(0, count);
+    CHECK_EQ(count, 2);
+    CHECK_EQ(s[0].src, 0);
+    CHECK_EQ(s[0].dst, 0);
+    CHECK_EQ(s[0].len, 50);
+    CHECK_EQ(s[1].src, 70);
+    CHECK_EQ(s[1].dst, 70);
+    CHECK_EQ(s[1].len, 30);
+
+    s = map.slices(1, count);
+    CHECK_EQ(count, 1);
+    CHECK_EQ(s[0].src, 0);
+    CHECK_EQ(s[0].dst, 50);
+    CHECK_EQ(s[0].len, 20);
+
+    checkTable(patch, 2, 2);
+}
+
+/* The table order decides, not the universe numbers */
+static void testOrder() {
+    const patch_t patch[] = {
+        { FIRST + 1, 1, 50, 20 },
+        { FIRST, 1, 0, 100 },
+    };
+    CHECK_EQ(map.begin(patch, 2, FIRST, 2), 1);
+    CHECK(map.isMapped(0));
+    CHECK(!map.isMapped(1));
+    checkTable(patch, 2, 2);
+
+    // Within one universe too, and a patch that ends up whole again stays one slice
+    const patch_t same[] = {
+        { FIRST, 1, 0, 40 },
+        { FIRST, 101, 20, 10 },
+        { FIRST, 11, 10, 20 },
+    };
+    map.begin(same, 3, FIRST, 1);
+    uint16_t count;
+    map.slices(0, count);
+    CHECK_EQ(count, 3);
+    checkTable(same, 3, 1);
+}
+
+/* Gaps, universes with no patch, and a table that splits as far as it can */
+static void testSparse() {
+    const patch_t gaps[] = {
+        { FIRST + 3, 5, 300, 10 },
+        { FIRST, 1, 0, 10 },
+        { FIRST + 3, 200, 100, 50 },
+    };
+    CHECK_EQ(map.begin(gaps, 3, FIRST, 4), 2);
+    CHECK(!map.isMapped(1));
+    CHECK(!map.isMapped(2));
+    CHECK(!map.isMapped(4));
+    checkTable(gaps, 3, 4);
+
+    // Each later patch lands inside the one before it
+    patch_t nested[PATCH_MAX];
+    for (uint8_t i = 0; i < PATCH_MAX; i++)
+        nested[i] = { static_cast<uint16_t>(FIRST + i % 5), static_cast<uint16_t>(1 + i),
+                static_cast<uint16_t>(i * 4), static_cast<uint16_t>(400 - i * 8) };
+    CHECK_EQ(map.begin(nested, PATCH_MAX, FIRST, 5), 5);
+    uint16_t total = 0, count;
+    for (uint8_t u = 0; u < 5; u++) {
+        map.slices(u, count);
+        total += count;
+    }
+    CHECK_EQ(total, PATCH_MAX * 2 - 1);
+    checkTable(nested, PATCH_MAX, 5);
+}
+
+/* Without a patch table universes go back to back from the start channel */
+static void testWindow() {
+    CHECK_EQ(map.begin(3, 510, SIZE, 3), 2);
+    uint16_t count;
+    const uni_slice_t *s = map.slices(0, count);
+    CHECK_EQ(count, 1);
+    CHECK_EQ(s[0].src, 2);
+    CHECK_EQ(s[0].dst, 0);
+    CHECK_EQ(s[0].len, 508);
+    s = map.slices(1, count);
+    CHECK_EQ(count, 1);
+    CHECK_EQ(s[0].src, 0);
+    CHECK_EQ(s[0].dst, 508);
+    CHECK_EQ(s[0].len, SIZE - 508);
+    CHECK(!map.isMapped(2));
+    CHECK(!map.isMapped(3));
+}
+
+int main() {
+    RUN(testOverlap);
+    RUN(testOrder);
+    RUN(testSparse);
+    RUN(testWindow);
+    return checkDone();
+}
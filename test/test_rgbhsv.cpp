@@ -0,0 +1,98 @@
+/*
+* test_rgbhsv.cpp - Integer color math against exact arithmetic
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include "rgbhsv.h"
+#include "check.h"
+
+/* n / 255 rounded half up, in whole numbers */
+static uint32_t div255(uint32_t n) {
+    return (2 * n + 255) / 510;
+}
+
+/* scale8() is a * b / 255 rounded for every pair */
+static void testScale8() {
+    uint32_t wrong = 0;
+    for (uint16_t a = 0; a < 256; a++) {
+        for (uint16_t b = 0; b < 256; b++)
+            wrong += scale8(a, b) != div255(a * b);
+    }
+    CHECK_EQ(wrong, 0);
+    CHECK_EQ(scale8(255, 255), 255);
+    CHECK_EQ(scale8(255, 0), 0);
+}
+
+/* blend8() is the rounded mix for every pair and alpha, and hits both ends */
+static void testBlend8() {
+    uint32_t wrong = 0, ends = 0;
+    for (uint16_t a = 0; a < 256; a++) {
+        for (uint16_t b = 0; b < 256; b++) {
+            for (uint16_t alpha = 0; alpha < 256; alpha++)
+                wrong += blend8(a, b, alpha) != div255(b * alpha + a * (255 - alpha));
+            ends += blend8(a, b, 0) != a || blend8(a, b, 255) != b;
+        }
+    }
+    CHECK_EQ(wrong, 0);
+    CHECK_EQ(ends, 0);
+}
+
+/* Every color comes back within 2 counts a channel */
+static void testRoundTrip() {
+    uint32_t over = 0;
+    int worst = 0;
+    for (uint32_t c = 0; c < 0x1000000; c++) {
+        CRGB in = { static_cast<uint8_t>(c >> 16), static_cast<uint8_t>(c >> 8), static_cast<uint8_t>(c) };
+        CRGB out = hsv2rgb(rgb2hsv(in));
+        int err = std::max(std::max(abs(out.r - in.r), abs(out.g - in.g)), abs(out.b - in.b));
+        worst = std::max(worst, err);
+        over += err > 2;
+    }
+    CHECK_EQ(over, 0);
+    CHECK(worst <= 2);
+}
+
+/* Primaries, greys and hue wrapping land where they should */
+static void testKnown() {
+    CHSV hsv = rgb2hsv({ 255, 0, 0 });
+    CHECK_EQ(hsv.h, 0);
+    CHECK_EQ(hsv.s, 255);
+    CHECK_EQ(hsv.v, 255);
+    CHECK_EQ(rgb2hsv({ 0, 255, 0 }).h, 21845);
+    CHECK_EQ(rgb2hsv({ 0, 0, 255 }).h, 43690);
+    CHECK_EQ(rgb2hsv({ 255, 0, 1 }).h > 65000, 1);
+
+    hsv = rgb2hsv({ 77, 77, 77 });
+    CHECK_EQ(hsv.s, 0);
+    CHECK_EQ(hsv.v, 77);
+
+    CRGB rgb = hsv2rgb({ 0, 0, 99 });
+    CHECK(rgb.r == 99 && rgb.g == 99 && rgb.b == 99);
+    rgb = hsv2rgb({ 21845, 255, 255 });
+    CHECK(rgb.r == 0 && rgb.g == 255 && rgb.b == 0);
+    rgb = hsv2rgb({ 65535, 255, 200 });
+    CHECK(rgb.r == 200 && rgb.g == 0 && rgb.b <= 1);
+}
+
+int main() {
+    RUN(testScale8);
+    RUN(testBlend8);
+    RUN(testRoundTrip);
+    RUN(testKnown);
+    return checkDone();
+}
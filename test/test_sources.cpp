@@ -0,0 +1,114 @@
+/*
+* test_sources.cpp - Merged E1.31 sources through the input frame
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include <vector>
+#include "SourceTable.h"
+#include "InputFrame.h"
+#include "check.h"
+
+#define UNIVERSES   2
+#define CHANNELS    4       /* Per universe, back to back in the frame */
+#define SIZE        (UNIVERSES * CHANNELS)
+
+typedef std::vector<uint8_t> bytes_t;
+
+static SourceTable  sources;
+static InputFrame   input;
+static bytes_t      shown;      // Last frame handed to the output
+static uint8_t      sequence[2][UNIVERSES];
+
+/* Arbitrate and write a packet from source a or b the way ingestE131() does */
+static void ingest(uint8_t from, uint8_t uni, const bytes_t &data) {
+    e131_packet_t p = {};
+    memset(p.cid, 'a' + from, sizeof(p.cid));
+    p.priority = 100;
+    p.universe = htons(uni + 1);
+    p.sequence_number = sequence[from][uni]++;
+
+    int8_t seqDiff;
+    int8_t src = sources.accept(p, uni, seqDiff);
+    if (src < 0)
+        return;
+
+    bool lead = sources.leads(src, uni);
+    if (lead && input.start(uni))
+        shown.assign(input.getData(), input.getData() + SIZE);
+    sources.write(src, uni, input.getData(), &data[0], uni * CHANNELS, CHANNELS);
+    if (lead && input.received(uni, 0))
+        shown.assign(input.getData(), input.getData() + SIZE);
+}
+
+static void start() {
+    simReset();
+    simRun(1000 * 1000);
+    sources.begin(SIZE, UNIVERSES, true);
+    input.begin(SIZE, UNIVERSES, UNIVERSES);
+    input.stats = {};
+    memset(sequence, 0, sizeof(sequence));
+    shown.clear();
+}
+
+/* Both sources send every universe, each frame latches complete and merged */
+static void testMerge() {
+    start();
+    for (uint8_t v = 10; v <= 50; v += 10) {
+        input.drain();
+        for (uint8_t uni = 0; uni < UNIVERSES; uni++) {
+            ingest(0, uni, { v, 0, 1, 0 });
+            ingest(1, uni, { 0, static_cast<uint8_t>(v / 2), 0, 1 });
+        }
+        simRun(25000);
+    }
+    CHECK_EQ(input.stats.frames_complete, 5);
+    CHECK_EQ(input.stats.frames_partial, 0);
+    CHECK_EQ(input.stats.superseded, 0);
+
+    // The last universe of a frame has the other source's data from the one before
+    CHECK(shown == bytes_t({ 50, 25, 1, 1, 50, 20, 1, 1 }));
+    CHECK(!input.poll());
+}
+
+/* The other source paces the frame once the first goes quiet and drops out of the merge */
+static void testHandover() {
+    start();
+    input.drain();
+    for (uint8_t uni = 0; uni < UNIVERSES; uni++) {
+        ingest(0, uni, { 10, 0, 0, 0 });
+        ingest(1, uni, { 0, 10, 0, 0 });
+    }
+    CHECK_EQ(input.stats.frames_complete, 1);
+
+    simRun((SOURCE_TIMEOUT + 100) * 1000);
+    for (uint8_t v = 20; v <= 40; v += 10) {
+        input.drain();
+        for (uint8_t uni = 0; uni < UNIVERSES; uni++)
+            ingest(1, uni, { 0, v, 0, 0 });
+        simRun(25000);
+    }
+    CHECK_EQ(input.stats.frames_complete, 4);
+    CHECK_EQ(input.stats.frames_partial, 0);
+    CHECK(shown == bytes_t({ 0, 40, 0, 0, 0, 40, 0, 0 }));
+}
+
+int main() {
+    RUN(testMerge);
+    RUN(testHandover);
+    return checkDone();
+}
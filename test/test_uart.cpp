@@ -0,0 +1,306 @@
+/*
+* test_uart.cpp - UART output drivers against the simulated UARTs
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+/* Built with ESPS_ENABLE_DUAL_OUTPUT, UART0 only carries data once split */
+
+#include <Arduino.h>
+#include "PixelDriver.h"
+#include "SerialDriver.h"
+#include "check.h"
+
+static PixelDriver  pixels;
+static SerialDriver serial;
+
+/* Channel values with every 2 bit symbol in every position */
+static const uint8_t PATTERN[] = { 0x00, 0xff, 0x1b, 0xe4, 0x55, 0xaa, 0x80, 0x01, 0x7e };
+
+/* One of each symbol, exact to the picosecond */
+static void testSymbols() {
+    simReset();
+    updateGammaTable(1.0, 1.0);
+    pixels.begin(PixelType::WS2811, PixelColor::RGB, 3);
+    pixels.setSplit(3, PixelColor::RGB);
+    pixels.setData(PATTERN, sizeof(PATTERN));
+    pixels.show();
+    simRun(1000);
+
+    uint32_t errors;
+    std::vector<sim_frame_t> frames = decodeWS2811(simUart[UART1].line, 0, errors);
+    CHECK_EQ(errors, 0);
+    CHECK_EQ(frames.size(), 1);
+    if (frames.size() != 1)
+        return;
+
+    CHECK(frames[0].data == std::vector<uint8_t>(PATTERN, PATTERN + sizeof(PATTERN)));
+
+    // 1.25us a bit, back to back, less the low end of the last one
+    uint64_t last = (PATTERN[8] & 1) ? 937500 : 312500;
+    CHECK_EQ(frames[0].end - frames[0].start, sizeof(PATTERN) * 8 * 1250000 - 1250000 + last);
+
+    // Nothing on the second output with everything on the first
+    CHECK(simUart[UART0].line.size() <= 1);
+    CHECK_EQ(PixelDriver::stats.frames_done, 1);
+}
+
+/* The symbols are gamma corrected */
+static void testGamma() {
+    simReset();
+    updateGammaTable(2.2, 1.0);
+    pixels.begin(PixelType::WS2811, PixelColor::RGB, 3);
+    pixels.setSplit(3, PixelColor::RGB);
+    pixels.setData(PATTERN, sizeof(PATTERN));
+    pixels.show();
+    simRun(1000);
+
+    uint32_t errors;
+    std::vector<sim_frame_t> frames = decodeWS2811(simUart[UART1].line, 0, errors);
+    CHECK_EQ(errors, 0);
+    CHECK_EQ(frames.size(), 1);
+    for (size_t i = 0; i < frames.size() && i < sizeof(PATTERN); i++) {
+        for (size_t c = 0; c < frames[i].data.size(); c++)
+            CHECK_EQ(frames[i].data[c], GAMMA_TABLE[PATTERN[c]] >> GAMMA_SHIFT);
+    }
+    updateGammaTable(1.0, 1.0);
+}
+
+/*
+* Dithering spreads the low gamma byte over frames, so the average of what
+* goes out comes to the 16 bit gamma value, within 255 / frames of a step.
+*/
+static void testDither() {
+    const uint16_t count = 86, frames = 256;
+    uint8_t data[count * 3];
+    for (uint16_t i = 0; i < sizeof(data); i++)
+        data[i] = i < 256 ? i : i - 3;
+
+    simReset();
+    PixelDriver::stats = {};
+    pixels.begin(PixelType::WS2811, PixelColor::RGB, count);
+    pixels.setSplit(count, PixelColor::RGB);
+    pixels.setDither(true);
+    updateGammaTable(2.2, 1.0, pixels.isDithering());
+    CHECK(pixels.isDithering());
+    CHECK(pixels.isDirty());
+
+    for (uint16_t f = 0; f < frames; f++) {
+        pixels.setData(data, sizeof(data));
+        pixels.show();
+        simRun(WS2811_TCHANNEL * sizeof(data) + WS2811_TIDLE);
+    }
+
+    // Viewers of the frame still get source levels
+    CHECK(!memcmp(pixels.getData(), data, sizeof(data)));
+
+    uint32_t errors;
+    std::vector<sim_frame_t> out = decodeWS2811(simUart[UART1].line, 0, errors);
+    CHECK_EQ(errors, 0);
+    CHECK_EQ(out.size(), frames);
+    if (out.size() != frames)
+        return;
+
+    uint32_t worst = 0, varied = 0;
+    for (uint16_t c = 0; c < sizeof(data); c++) {
+        uint32_t sum = 0;
+        for (uint16_t f = 0; f < frames; f++)
+            sum += out[f].data[c];
+        varied += out[0].data[c] != out[1].data[c];
+
+        // sum / frames against GAMMA_TABLE / 256 in whole numbers, 255 is as high as it goes
+        int32_t target = std::min(GAMMA_TABLE[data[c]], static_cast<uint16_t>(0xff00));
+        int32_t diff = static_cast<int32_t>(sum * 256 / frames) - target;
+        worst = std::max(worst, static_cast<uint32_t>(abs(diff)));
+    }
+    CHECK(worst <= 1);
+    CHECK(varied > 0);
+
+    // The ends stay put
+    bool ends = true;
+    for (uint16_t f = 0; f < frames; f++)
+        ends &= out[f].data[0] == 0 && out[f].data[255] == 255;
+    CHECK(ends);
+
+    pixels.setDither(false);
+    updateGammaTable(1.0, 1.0);
+}
+
+/*
+* Long enough to need many FIFO refills on both outputs. Each output gets
+* its own part of the frame in its own color order, in parallel.
+*/
+static void testDual() {
+    const uint16_t count = 300, split = 120;
+    uint8_t data[count * 3];
+    for (uint16_t i = 0; i < sizeof(data); i++)
+        data[i] = i * 7 + i / 3;
+
+    simReset();
+    updateGammaTable(1.0, 1.0);
+    PixelDriver::stats = {};
+    pixels.begin(PixelType::WS2811, PixelColor::GRB, count);
+    pixels.setSplit(split, PixelColor::BGR);
+    pixels.setData(data, sizeof(data));
+    pixels.show();
+    CHECK(!pixels.canRefresh());
+    simRun(20000);
+
+    uint32_t errors1, errors0;
+    std::vector<sim_frame_t> out1 = decodeWS2811(simUart[UART1].line, 0, errors1);
+    std::vector<sim_frame_t> out0 = decodeWS2811(simUart[UART0].line, 0, errors0);
+    CHECK_EQ(errors1, 0);
+    CHECK_EQ(errors0, 0);
+    CHECK_EQ(out1.size(), 1);
+    CHECK_EQ(out0.size(), 1);
+    if (out1.size() != 1 || out0.size() != 1)
+        return;
+
+    CHECK_EQ(out1[0].data.size(), split * 3);
+    CHECK_EQ(out0[0].data.size(), (count - split) * 3);
+
+    bool grb = out1[0].data.size() == split * 3;
+    for (uint16_t p = 0; grb && p < split; p++) {
+        const uint8_t *px = data + p * 3;
+        const uint8_t *wire = &out1[0].data[p * 3];
+        grb = wire[0] == px[1] && wire[1] == px[0] && wire[2] == px[2];
+    }
+    CHECK(grb);
+
+    bool bgr = out0[0].data.size() == (count - split) * 3;
+    for (uint16_t p = split; bgr && p < count; p++) {
+        const uint8_t *px = data + p * 3;
+        const uint8_t *wire = &out0[0].data[(p - split) * 3];
+        bgr = wire[0] == px[2] && wire[1] == px[1] && wire[2] == px[0];
+    }
+    CHECK(bgr);
+
+    // Started together, no gaps, one frame counted once both finished
+    CHECK(out0[0].start - out1[0].start < 10 * SIM_PS_US);
+    CHECK_EQ(PixelDriver::stats.underruns, 0);
+    CHECK_EQ(PixelDriver::stats.frames_done, 1);
+    CHECK_EQ(simUart[UART1].overflows + simUart[UART0].overflows, 0);
+    CHECK(PixelDriver::stats.isr_count >= (count - split) * 3 * 4 / UART_TX_FIFO_SIZE);
+
+    // The slower output ends inside the refresh time
+    uint64_t end = std::max(out0[0].end, out1[0].end);
+    CHECK(end / SIM_PS_US < (WS2811_TCHANNEL * 3 * (count - split) + WS2811_TIDLE));
+}
+
+/* RGBW goes out four channels a pixel */
+static void testRGBW() {
+    const uint8_t data[] = { 1, 2, 3, 4, 250, 251, 252, 253 };
+
+    simReset();
+    updateGammaTable(1.0, 1.0);
+    pixels.begin(PixelType::WS2811, PixelColor::GRBW, 2);
+    pixels.setSplit(2, PixelColor::GRBW);
+    pixels.setData(data, sizeof(data));
+    pixels.show();
+    simRun(1000);
+
+    uint32_t errors;
+    std::vector<sim_frame_t> frames = decodeWS2811(simUart[UART1].line, 0, errors);
+    CHECK_EQ(errors, 0);
+    CHECK_EQ(frames.size(), 1);
+    if (frames.size() == 1) {
+        const uint8_t grbw[] = { 2, 1, 3, 4, 251, 250, 252, 253 };
+        CHECK(frames[0].data == std::vector<uint8_t>(grbw, grbw + sizeof(grbw)));
+    }
+}
+
+/* DMX - break, mark after break, start code and the channels at 250k 8N2 */
+static void testDMX() {
+    const uint8_t data[] = { 0, 1, 127, 128, 255, 0x55 };
+
+    simReset();
+    serial.begin(&Serial1, SerialType::DMX512, sizeof(data));
+    serial.setData(data, sizeof(data));
+    serial.show();
+    simRun(1000);
+
+    uint32_t errors;
+    std::vector<int> bytes = decodeSerial(simUart[UART1].line, 250000, 8, 2, errors);
+    CHECK_EQ(errors, 0);
+    CHECK_EQ(bytes.size(), sizeof(data) + 2);
+    if (bytes.size() == sizeof(data) + 2) {
+        CHECK_EQ(bytes[0], -1);
+        CHECK_EQ(bytes[1], 0);
+        for (uint8_t i = 0; i < sizeof(data); i++)
+            CHECK_EQ(bytes[i + 2], data[i]);
+    }
+
+    // Break and mark after break
+    const std::vector<sim_edge_t> &line = simUart[UART1].line;
+    CHECK(line.size() > 2);
+    if (line.size() > 2) {
+        CHECK(line[1].time - line[0].time >= DMX_BREAK * SIM_PS_US);
+        CHECK(line[2].time - line[1].time >= DMX_MAB * SIM_PS_US);
+    }
+}
+
+/* Renard - sync and address, then the channels with 0x7d-0x7f escaped away */
+static void testRenard() {
+    const uint8_t data[] = { 0x10, 0x7d, 0x7e, 0x7f, 0xff };
+    const int sent[] = { 0x7e, 0x80, 0x10, 0x7c, 0x80, 0x80, 0xff };
+
+    simReset();
+    serial.begin(&Serial1, SerialType::RENARD, sizeof(data), BaudRate::BR_57600);
+    serial.setData(data, sizeof(data));
+    serial.show();
+    simRun(2000);
+
+    uint32_t errors;
+    std::vector<int> bytes = decodeSerial(simUart[UART1].line, 57600, 8, 1, errors);
+    CHECK_EQ(errors, 0);
+    CHECK(bytes == std::vector<int>(sent, sent + 7));
+}
+
+/* Skipping leaves the last frame's start alone, one count per refresh time */
+static void testSkip() {
+    const uint8_t data[30] = { 1 };
+
+    simReset();
+    PixelDriver::stats = {};
+    pixels.begin(PixelType::WS2811, PixelColor::RGB, 10);
+    pixels.setSplit(10, PixelColor::RGB);
+    pixels.setData(data, sizeof(data));
+    pixels.show();
+    simRun(WS2811_TCHANNEL * 30 + WS2811_TIDLE);
+    CHECK(pixels.canRefresh());
+
+    for (uint8_t i = 0; i < 100; i++)
+        pixels.skip();
+    CHECK(pixels.canRefresh());
+    CHECK_EQ(PixelDriver::stats.frames_skipped, 1);
+
+    simRun(WS2811_TCHANNEL * 30 + WS2811_TIDLE);
+    pixels.skip();
+    pixels.skip();
+    CHECK_EQ(PixelDriver::stats.frames_skipped, 2);
+}
+
+int main() {
+    RUN(testSymbols);
+    RUN(testGamma);
+    RUN(testDither);
+    RUN(testDual);
+    RUN(testRGBW);
+    RUN(testDMX);
+    RUN(testRenard);
+    RUN(testSkip);
+    return checkDone();
+}
@@ -0,0 +1,242 @@
+/*
+* test_vm.cpp - Effect program compiler and VM
+*
+* Project: ESPixelStick - An ESP8266 and E1.31 based pixel driver
+* Copyright (c) 2015 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+
+#include <Arduino.h>
+#include <FS.h>
+#include "EffectVM.h"
+#include "check.h"
+
+static EffectVM vm;
+
+/* Run source for one pixel of a string of n, r comes back as an int */
+static int eval(const char *source, int32_t i = 0, uint16_t n = 1) {
+    String error;
+    if (!vm.compile(source, error)) {
+        printf("  %s: %s\n", source, error.c_str());
+        return -1;
+    }
+    CRGB frame[n];
+    vm.render(frame, n, 1000, 7, { 10, 20, 30 });
+    return frame[i].r;
+}
+
+/* The compiler error for source, empty if it compiled */
+static String fails(const char *source) {
+    String error;
+    if (vm.compile(source, error))
+        return String();
+    return error;
+}
+
+/* Each word, through = where the answer is outside 0-255 */
+static void testWords() {
+    CHECK_EQ(eval("3 4 + 0 0"), 7);
+    CHECK_EQ(eval("3 4 - -1 = 0 0"), 1);
+    CHECK_EQ(eval("12 12 * 0 0"), 144);
+    CHECK_EQ(eval("-7 2 / -3 = 0 0"), 1);
+    CHECK_EQ(eval("-7 2 % -1 = 0 0"), 1);
+    CHECK_EQ(eval("5 neg -5 = 0 0"), 1);
+    CHECK_EQ(eval("-5 abs 0 0"), 5);
+    CHECK_EQ(eval("3 9 min 0 0"), 3);
+    CHECK_EQ(eval("3 9 max 0 0"), 9);
+    CHECK_EQ(eval("12 10 & 0 0"), 8);
+    CHECK_EQ(eval("12 10 | 0 0"), 14);
+    CHECK_EQ(eval("12 10 ^ 0 0"), 6);
+    CHECK_EQ(eval("1 7 << 0 0"), 128);
+    CHECK_EQ(eval("-256 4 >> -16 = 0 0"), 1);
+    CHECK_EQ(eval("1 2 < 2 1 < 1 1 ="), 1);
+    CHECK_EQ(eval("2 1 > 0 0"), 1);
+    CHECK_EQ(eval("1 11 22 ? 0 0"), 11);
+    CHECK_EQ(eval("0 11 22 ? 0 0"), 22);
+    CHECK_EQ(eval("9 dup + 0 0"), 18);
+    CHECK_EQ(eval("1 2 drop 0 0"), 1);
+    CHECK_EQ(eval("1 2 swap 0"), 2);
+    CHECK_EQ(eval("1 2 over"), 1);
+    CHECK_EQ(eval("200 100 scale 0 0"), 78);
+
+    // Numbers take all three literal sizes
+    CHECK_EQ(eval("-128 -128 = 0 0"), 1);
+    CHECK_EQ(eval("1000 1000 = 0 0"), 1);
+    CHECK_EQ(eval("100000 1000 / 0 0"), 100);
+    CHECK_EQ(eval("-2147483647 -2147483647 = 0 0"), 1);
+}
+
+/* Inputs, and which programs run once a frame */
+static void testInputs() {
+    CHECK_EQ(eval("t 1000 = 0 0"), 1);
+    CHECK_EQ(eval("s 0 0"), 7);
+    CHECK_EQ(eval("r g b"), 10);
+    CHECK_EQ(eval("n 0 0", 0, 40), 40);
+    CHECK_EQ(eval("i 0 0", 33, 40), 33);
+    CHECK_EQ(eval("x 0 0", 20, 40), 127);
+    CHECK_EQ(eval("x 0 0", 39, 40), 249);
+
+    // Without i, x or rand every pixel is the same
+    String error;
+    CHECK(vm.compile("t sin 0 0", error));
+    CRGB frame[8];
+    vm.render(frame, 8, 64, 0, {});
+    bool same = true;
+    for (uint8_t p = 0; p < 8; p++)
+        same &= frame[p].r == frame[0].r;
+    CHECK(same);
+    CHECK_EQ(frame[0].r, 255);
+}
+
+/* Edge cases the CPU would trap or overflow on */
+static void testArithmetic() {
+    CHECK_EQ(eval("5 0 / 0 0"), 0);
+    CHECK_EQ(eval("5 0 % 0 0"), 0);
+    CHECK_EQ(eval("-2147483647 1 - -1 / -2147483647 1 - = 0 0"), 1);
+    CHECK_EQ(eval("-2147483647 1 - -1 % 0 0"), 0);
+    CHECK_EQ(eval("1 33 << 2 = 0 0"), 1);
+    CHECK_EQ(eval("2147483647 1 + -2147483647 1 - = 0 0"), 1);
+    CHECK_EQ(eval("-2147483647 1 - neg -2147483647 1 - = 0 0"), 1);
+    CHECK_EQ(eval("-2147483647 1 - abs 0 < 0 0"), 1);
+    CHECK_EQ(eval("65536 65536 * 0 0"), 0);
+    CHECK_EQ(eval("100000 100000 scale 0 = 0 0"), 0);
+
+    // Outputs clamp to 0-255
+    CHECK_EQ(eval("300 0 0"), 255);
+    CHECK_EQ(eval("-300 0 0"), 0);
+}
+
+/* Built in waves */
+static void testBuiltins() {
+    CHECK_EQ(eval("0 sin 0 0"), 128);
+    CHECK_EQ(eval("64 sin 0 0"), 255);
+    CHECK_EQ(eval("192 sin 0 0"), 1);
+    CHECK_EQ(eval("256 sin 0 0"), 128);
+    CHECK_EQ(eval("0 tri 0 0"), 0);
+    CHECK_EQ(eval("64 tri 0 0"), 128);
+    CHECK_EQ(eval("255 tri 0 0"), 1);
+    CHECK_EQ(eval("0 255 255 hsv"), 255);
+    CHECK_EQ(eval("0 0 77 hsv"), 77);
+
+    // Noise is continuous, rand stays in range
+    bool smooth = true;
+    String error;
+    for (int32_t p = 0; p < 1024; p++) {
+        char source[40];
+        snprintf(source, sizeof(source), "%d noise %d noise - abs 0 0", p, p + 1);
+        smooth &= eval(source) <= 4;
+    }
+    CHECK(smooth);
+    CHECK(vm.compile("rand dup 0 < swap 255 > | 0 0", error));
+    CRGB frame[200];
+    vm.render(frame, 200, 0, 0, {});
+    bool range = true;
+    for (uint8_t p = 0; p < 200; p++)
+        range &= !frame[p].r;
+    CHECK(range);
+}
+
+/* Bad programs are refused and the last good one kept */
+static void testErrors() {
+    CHECK_EQ(eval("1 2 3"), 1);
+    CHECK(fails("1 2 foo").length());
+    CHECK(fails("1 2").length());
+    CHECK(fails("1 2 3 4").length());
+    CHECK(fails("1 + 2 3").length());
+    CHECK(fails("1 2 ?").length());
+    CHECK(fails("12x 0 0").length());
+    CHECK(fails("1 2 averyveryverylongword").length());
+    CHECK(fails("1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1").length());
+    CHECK(!fails("1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 + + + + + + + + + + + + +").length());
+
+    std::string big;
+    for (int i = 0; i < 60; i++)
+        big += "100000 drop ";
+    big += "0 0 0";
+    CHECK(fails(big.c_str()).length());
+
+    std::string huge(VM_SOURCE_MAX + 1, ' ');
+    CHECK(fails(huge.c_str()).length());
+
+    String error;
+
+    // Comments
+    CHECK_EQ(eval("# red\n5 # green\n0 0"), 5);
+
+    // Still running the last program that compiled
+    vm.compile("1 2 3", error);
+    fails("bad");
+    CRGB frame[1];
+    vm.render(frame, 1, 0, 0, {});
+    CHECK_EQ(frame[0].r, 1);
+}
+
+/* Saved programs load back, damaged ones are refused */
+static void testStorage() {
+    String error;
+    SPIFFS.files.clear();
+    CHECK(vm.compile("x t + 200 100 hsv", error));
+    CHECK(vm.save("x t + 200 100 hsv"));
+    CHECK(SPIFFS.files[VM_SOURCE_FILE] == "x t + 200 100 hsv");
+    uint16_t size = vm.size();
+
+    EffectVM loaded;
+    CHECK(loaded.load());
+    CHECK_EQ(loaded.size(), size);
+    CRGB a[16], b[16];
+    vm.render(a, 16, 123, 0, {});
+    loaded.render(b, 16, 123, 0, {});
+    CHECK(!memcmp(a, b, sizeof(a)));
+
+    // Opcode out of range, stack overflow, truncated literal, bad header
+    std::string good = SPIFFS.files[VM_CODE_FILE];
+    std::string bad = good;
+    bad[6] = 0xee;
+    SPIFFS.files[VM_CODE_FILE] = bad;
+    CHECK(!loaded.load());
+    CHECK_EQ(loaded.size(), 0);
+
+    bad = good;
+    bad.insert(6, std::string(VM_STACK, 3));
+    bad[4] += VM_STACK;
+    SPIFFS.files[VM_CODE_FILE] = bad;
+    CHECK(!loaded.load());
+
+    bad = good.substr(0, 6) + std::string(1, 2) + "\x01\x02";
+    bad[4] = 3;
+    bad[5] = 0;
+    SPIFFS.files[VM_CODE_FILE] = bad;
+    CHECK(!loaded.load());
+
+    bad = good;
+    bad[2] = VM_VERSION + 1;
+    SPIFFS.files[VM_CODE_FILE] = bad;
+    CHECK(!loaded.load());
+
+    // Nothing to render with no program and no pixels
+    CRGB frame[1] = { { 9, 9, 9 } };
+    loaded.render(frame, 1, 0, 0, {});
+    CHECK_EQ(frame[0].r, 0);
+    vm.render(frame, 0, 0, 0, {});
+}
+
+int main() {
+    RUN(testWords);
+    RUN(testInputs);
+    RUN(testArithmetic);
+    RUN(testBuiltins);
+    RUN(testErrors);
+    RUN(testStorage);
+    return checkDone();
+}
@@ -81,6 +81,7 @@ void UdpRaw::onPacket(AsyncUDPPacket packet)
             if (nzero > 0)
                 memset(_driver.getData() + nread, 0, nzero);
         }
+        _driver.markDirty();
     }
 }
 
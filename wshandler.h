@@ -40,9 +40,13 @@ extern UdpRaw       udpraw;
 extern EffectEngine effects;    // EffectEngine for test modes
 
 extern AsyncWebSocket ws;
-extern ESPAsyncE131 e131;       // ESPAsyncE131 with X buffers
+extern E131Rx       e131;       // E1.31 receiver with X slots
+extern InputFrame   input;      // E1.31 back buffer
+extern SourceTable  sources;    // E1.31 senders
+extern ArtNetRx     artnet;     // Art-Net receiver with X slots
+extern DdpRx        ddp;        // DDP receiver with X slots
 extern config_t     config;     // Current configuration
-extern uint32_t     *seqError;  // Sequence error tracking for each universe
+extern UniverseStats uniStats;  // Loss, jitter and latency tracking for each universe
 extern uint16_t     uniLast;    // Last Universe to listen for
 extern bool         reboot;     // Reboot flag
 
@@ -59,6 +63,7 @@ extern const char CONFIG_FILE[];
     G2 - Get Config Status
     G3 - Get Current Effect and Effect Config Options
     G4 - Get Gamma table values
+    G5 - Get Effect Program source
 
     T0 - Disable Testing
     T1 - Static Testing
@@ -69,15 +74,18 @@ extern const char CONFIG_FILE[];
     T6 - Fire flicker
     T7 - Lightning
     T8 - Breathe
+    T9 - Effect Program
 
-    V1 - View Stream
+    V1 - View Stream, binary
 
     S1 - Set Network Config
     S2 - Set Device Config
     S3 - Set Effect Startup Config
     S4 - Set Gamma and Brightness (but dont save)
+    S5 - Compile and save Effect Program
 
     XJ - Get RSSI,heap,uptime, e131 stats
+    XS - Get per universe stats, binary
 
     X6 - Reboot
 */
@@ -138,23 +146,85 @@ void procX(uint8_t *data, AsyncWebSocketClient *client) {
 
             // E131 statistics
             JsonObject &e131J = json.createNestedObject("e131");
-            uint32_t seqErrors = 0;
-            for (int i = 0; i < ((uniLast + 1) - config.universe); i++)
-                seqErrors =+ seqError[i];
-
             e131J["universe"] = (String)config.universe;
             e131J["uniLast"] = (String)uniLast;
             e131J["num_packets"] = (String)e131.stats.num_packets;
-            e131J["seq_errors"] = (String)seqErrors;
+            e131J["seq_errors"] = (String)uniStats.seqErrors();
             e131J["packet_errors"] = (String)e131.stats.packet_errors;
+            e131J["filtered"] = (String)e131.stats.filtered;
+            e131J["overruns"] = (String)e131.stats.overruns;
             e131J["last_clientIP"] = e131.stats.last_clientIP.toString();
             e131J["last_seen"] = e131.stats.last_seen ? (String) (millis() - e131.stats.last_seen) : "never";
+            e131J["frames_complete"] = (String)input.stats.frames_complete;
+            e131J["frames_partial"] = (String)input.stats.frames_partial;
+            e131J["frames_synced"] = (String)input.stats.frames_synced;
+            e131J["sync_packets"] = (String)input.stats.sync_packets;
+            e131J["superseded"] = (String)input.stats.superseded;
+            e131J["sources_rejected"] = (String)sources.stats.rejected;
+
+            // Per source statistics, for everyone we've heard from
+            JsonArray &sourceJ = e131J.createNestedArray("sources");
+            for (uint8_t i = 0; i < SOURCE_MAX; i++) {
+                if (!sources.source[i].packets)
+                    continue;
+                JsonObject &src = sourceJ.createNestedObject();
+                src["name"] = sources.source[i].name;
+                src["priority"] = (String)sources.source[i].priority;
+                src["active"] = sources.isActive(i);
+                src["packets"] = (String)sources.source[i].packets;
+                src["seq_errors"] = (String)sources.source[i].seq_errors;
+                src["late"] = (String)sources.source[i].late;
+                src["outranked"] = (String)sources.source[i].outranked;
+                src["last_seen"] = (String)(millis() - sources.source[i].last_seen);
+            }
+
+            // Output statistics
+            JsonObject &output = json.createNestedObject("output");
+#if defined(ESPS_MODE_PIXEL)
+            output["frames_shown"] = (String)pixels.stats.frames_shown;
+            output["frames_skipped"] = (String)pixels.stats.frames_skipped;
+            output["frames_done"] = (String)pixels.stats.frames_done;
+            output["fps"] = (String)pixels.stats.fps;
+            output["underruns"] = (String)pixels.stats.underruns;
+            output["isr_min"] = (String)(pixels.stats.isr_min / static_cast<float>(ESP.getCpuFreqMHz()));
+            output["isr_avg"] = (String)(pixels.stats.isr_avg / static_cast<float>(ESP.getCpuFreqMHz()));
+            output["isr_max"] = (String)(pixels.stats.isr_max / static_cast<float>(ESP.getCpuFreqMHz()));
+#elif defined(ESPS_MODE_SERIAL)
+            output["frames_shown"] = (String)serial.stats.frames_shown;
+            output["frames_skipped"] = (String)serial.stats.frames_skipped;
+#endif
 
             // MQTT statistics
             JsonObject &mqtt = json.createNestedObject("mqtt");
             mqtt["num_packets"] = (String)mqtt_num_packets;
             mqtt["last_seen"] = mqtt_last_seen ? (String) (millis() - mqtt_last_seen) : "never";
 
+            // Art-Net statistics
+            JsonObject &artnetJ = json.createNestedObject("artnet");
+            artnetJ["num_packets"] = (String)artnet.stats.num_packets;
+            artnetJ["sync_packets"] = (String)artnet.stats.sync_packets;
+            artnetJ["polls"] = (String)artnet.stats.polls;
+            artnetJ["packet_errors"] = (String)artnet.stats.packet_errors;
+            artnetJ["filtered"] = (String)artnet.stats.filtered;
+            artnetJ["seq_errors"] = (String)artnet.stats.seq_errors;
+            artnetJ["late"] = (String)artnet.stats.late;
+            artnetJ["overruns"] = (String)artnet.stats.overruns;
+            artnetJ["last_clientIP"] = artnet.stats.last_clientIP.toString();
+            artnetJ["last_seen"] = artnet.stats.last_seen ? (String) (millis() - artnet.stats.last_seen) : "never";
+
+            // DDP statistics
+            JsonObject &ddpJ = json.createNestedObject("ddp");
+            ddpJ["num_packets"] = (String)ddp.stats.num_packets;
+            ddpJ["push_packets"] = (String)ddp.stats.push_packets;
+            ddpJ["seq_errors"] = (String)ddp.stats.seq_errors;
+            ddpJ["packet_errors"] = (String)ddp.stats.packet_errors;
+            ddpJ["overruns"] = (String)ddp.stats.overruns;
+            ddpJ["last_clientIP"] = ddp.stats.last_clientIP.toString();
+            ddpJ["last_seen"] = ddp.stats.last_seen ? (String) (millis() - ddp.stats.last_seen) : "never";
+
+            // Effect and layer render times
+            effects.layersToJson(json);
+
 #if defined(ESPS_ENABLE_UDPRAW)
             // UDP raw statistics
             JsonObject &udp = json.createNestedObject("udp");
@@ -170,6 +240,16 @@ void procX(uint8_t *data, AsyncWebSocketClient *client) {
             client->text("XJ" + response);
             break;
         }
+        case 'S': {  // Per universe stats, see UniverseStats.h for the layout
+            size_t len = uniStats.size();
+            uint8_t *buf = static_cast<uint8_t *>(malloc(len));
+            if (buf) {
+                uniStats.serialize(buf, config.universe);
+                client->binary(buf, len);
+                free(buf);
+            }
+            break;
+        }
         case '6':  // Init 6 baby, reboot!
             reboot = true;
     }
@@ -187,6 +267,7 @@ void procE(uint8_t *data, AsyncWebSocketClient *client) {
             JsonObject &p_type = json.createNestedObject("p_type");
             p_type["WS2811 800kHz"] = static_cast<uint8_t>(PixelType::WS2811);
             p_type["GE Color Effects"] = static_cast<uint8_t>(PixelType::GECE);
+            p_type["APA102 / SK9822"] = static_cast<uint8_t>(PixelType::APA102);
 
             // Pixel Colors
             JsonObject &p_color = json.createNestedObject("p_color");
@@ -196,6 +277,8 @@ void procE(uint8_t *data, AsyncWebSocketClient *client) {
             p_color["RBG"] = static_cast<uint8_t>(PixelColor::RBG);
             p_color["GBR"] = static_cast<uint8_t>(PixelColor::GBR);
             p_color["BGR"] = static_cast<uint8_t>(PixelColor::BGR);
+            p_color["RGBW"] = static_cast<uint8_t>(PixelColor::RGBW);
+            p_color["GRBW"] = static_cast<uint8_t>(PixelColor::GRBW);
 
 #elif defined (ESPS_MODE_SERIAL)
             // Serial Protocols
@@ -282,6 +365,17 @@ void procG(uint8_t *data, AsyncWebSocketClient *client) {
             client->text("G4" + response);
             break;
         }
+
+        case '5': {
+            String response;
+            File file = SPIFFS.open(VM_SOURCE_FILE, "r");
+            if (file) {
+                response = file.readString();
+                file.close();
+            }
+            client->text("G5" + response);
+            break;
+        }
     }
 }
 
@@ -327,6 +421,20 @@ void procS(uint8_t *data, AsyncWebSocketClient *client) {
             dsGammaConfig(json);
             client->text("S4");
             break;
+        case '5': { // Compile and save the effect program
+            String error;
+            const char *source = json["program"];
+            DynamicJsonBuffer replyBuffer;
+            JsonObject &reply = replyBuffer.createObject();
+            if (effects.setProgram(source ? source : "", error))
+                reply["size"] = effects.getProgramSize();
+            else
+                reply["error"] = error;
+            String response;
+            reply.printTo(response);
+            client->text("S5" + response);
+            break;
+        }
     }
 }
 
@@ -337,7 +445,7 @@ void procT(uint8_t *data, AsyncWebSocketClient *client) {
             config.ds = DataSource::E131;
             effects.clearAll();
     }
-    else if ( (data[1] >= '1') && (data[1] <= '8') ) {
+    else if ( (data[1] >= '1') && (data[1] <= '9') ) {
         String TCode;
         TCode += (char)data[0];
         TCode += (char)data[1];
@@ -389,15 +497,20 @@ void procT(uint8_t *data, AsyncWebSocketClient *client) {
 
 void procV(uint8_t *data, AsyncWebSocketClient *client) {
     switch (data[1]) {
-        case '1': {  // View stream
+        case '1': {  // View stream, tagged 'V1' as binary stats are 'XS'
 #if defined(ESPS_MODE_PIXEL)
-            client->binary(pixels.getData(), config.channel_count);
+            const uint8_t *frame = pixels.getData();
 #elif defined(ESPS_MODE_SERIAL)
-            if (config.serial_type == SerialType::DMX512)
-                client->binary(&serial.getData()[1], config.channel_count);
-            else
-                client->binary(&serial.getData()[2], config.channel_count);
+            const uint8_t *frame = &serial.getData()[config.serial_type == SerialType::DMX512 ? 1 : 2];
 #endif
+            uint8_t *buf = static_cast<uint8_t *>(malloc(config.channel_count + 2));
+            if (buf) {
+                buf[0] = 'V';
+                buf[1] = '1';
+                memcpy(buf + 2, frame, config.channel_count);
+                client->binary(buf, config.channel_count + 2);
+                free(buf);
+            }
             break;
         }
     }